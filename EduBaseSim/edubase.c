@@ -0,0 +1,521 @@
+// edubase.c
+// Runs on the host (Linux, gcc)
+// Peripheral models for the virtual TM4C123 + EduBase-V2, see sim.h.
+//   SSI2       8-entry TX FIFO, shifter, SR (TFE/TNF/BSY), TX interrupt
+//              (FIFO half empty, or end of transmission when CR1.EOT = 1)
+//   74HC595    every register clocks in each SSI2 frame; the rising edge
+//              of its chip select copies the chain to the outputs
+//              PC6: one register, Q0=RS Q1=E Q4-Q7=D4-D7 of the LCD
+//              PC7: two chained registers, first byte = segments
+//              (active low), second byte = digit enables (0x08 = left)
+//   HD44780    8-bit power-on state, 4-bit mode after function set 0x2,
+//              execution times from the datasheet at fosc = 270 kHz
+//   GPTM       Timer0-5, WTimer0-5 timer A one-shot/periodic down count,
+//              32-bit (CFG=0) or 16-bit with prescale (CFG=4)
+//   SYSCTL     peripherals ready at once, PLL always locked, the bus
+//              clock set by RCC2 (16 MHz crystal while BYPASS2)
+
+#include <stdint.h>
+#include <string.h>
+#include "sim.h"
+
+//---------- register addresses ----------
+#define SYSCTL_RIS      0x400FE050
+#define SYSCTL_RCC2     0x400FE070
+#define SYSCTL_PLLSTAT  0x400FE168
+#define SYSCTL_RCGC     0x400FE600  // RCGCWD..RCGCWTIMER
+#define SYSCTL_PR       0x400FEA00  // PRWD..PRWTIMER
+#define GPIO_PORTC_DATA 0x400063FC
+#define SSI2_BASE       0x4000A000
+#define SSI_CR0         0x000
+#define SSI_CR1         0x004
+#define SSI_DR          0x008
+#define SSI_SR          0x00C
+#define SSI_CPSR        0x010
+#define SSI_IM          0x014
+#define SSI_RIS         0x018
+#define SSI_MIS         0x01C
+#define SSI_ICR         0x020
+#define TIMER_CFG       0x000
+#define TIMER_TAMR      0x004
+#define TIMER_CTL       0x00C
+#define TIMER_IMR       0x018
+#define TIMER_RIS       0x01C
+#define TIMER_MIS       0x020
+#define TIMER_ICR       0x024
+#define TIMER_TAILR     0x028
+#define TIMER_TAPR      0x038
+#define TIMER_TAR       0x048
+#define TIMER_TAV       0x050
+
+#define DR_PRESET       0xDEADBEEF  // SSI2_DR before a store, never written
+
+// nanoseconds to bus cycles, rounded up
+static uint64_t NsToCycles(uint64_t ns){
+  return (ns*Sim_BusHz() + 999999999)/1000000000;
+}
+
+//---------- SSI2 ----------
+#define SSIFIFO 8
+static struct{
+  uint8_t fifo[SSIFIFO];
+  int head, count;
+  int shifting;
+  uint8_t shiftByte;
+  uint64_t shiftEnd;
+} Ssi;
+
+static void ShiftRegistersClock(uint8_t data);
+
+static uint32_t SsiFrameCycles(void){
+  uint32_t cr0 = Sim_Peek(SSI2_BASE+SSI_CR0);
+  uint32_t cpsr = Sim_Peek(SSI2_BASE+SSI_CPSR)&0xFF;
+  uint32_t scr = (cr0>>8)&0xFF;
+  uint32_t bits = (cr0&0xF)+1;
+  if(cpsr < 2){
+    cpsr = 2;                   // minimum legal prescale
+  }
+  return cpsr*(scr+1)*bits;
+}
+
+static int SsiEnabled(void){
+  return (Sim_Peek(SSI2_BASE+SSI_CR1)&0x02) != 0;
+}
+
+static void SsiStart(uint64_t t){
+  Ssi.shiftByte = Ssi.fifo[Ssi.head];
+  Ssi.head = (Ssi.head+1)%SSIFIFO;
+  Ssi.count--;
+  Ssi.shifting = 1;
+  Ssi.shiftEnd = t + SsiFrameCycles();
+  SimStat.ssiBusyCycles += SsiFrameCycles();
+}
+
+static void SsiAdvance(uint64_t now){
+  while(Ssi.shifting && (Ssi.shiftEnd <= now)){
+    Ssi.shifting = 0;
+    SimStat.ssiFrames++;
+    ShiftRegistersClock(Ssi.shiftByte);
+    if(Ssi.count && SsiEnabled()){
+      SsiStart(Ssi.shiftEnd);
+    }
+  }
+}
+
+static void SsiPush(uint8_t data, uint64_t now){
+  if(Ssi.count == SSIFIFO){
+    SimStat.v.fifoOverrun++;
+    return;
+  }
+  Ssi.fifo[(Ssi.head+Ssi.count)%SSIFIFO] = data;
+  Ssi.count++;
+  if(!Ssi.shifting && SsiEnabled()){
+    SsiStart(now);
+  }
+}
+
+static uint32_t SsiStatus(void){
+  uint32_t sr = 0;
+  if(Ssi.count == 0) sr |= 0x01;            // TFE
+  if(Ssi.count < SSIFIFO) sr |= 0x02;       // TNF
+  if(Ssi.shifting || Ssi.count) sr |= 0x10; // BSY
+  return sr;
+}
+
+static uint32_t SsiRaw(void){
+  if(Sim_Peek(SSI2_BASE+SSI_CR1)&0x10){     // EOT: TXRIS when all sent
+    return (Ssi.count == 0 && !Ssi.shifting) ? 0x08 : 0;
+  }
+  return (Ssi.count <= SSIFIFO/2) ? 0x08 : 0;
+}
+
+//---------- HD44780 ----------
+#define LCD_CLEAR_NS    1520000
+#define LCD_CMD_NS      37000
+#define LCD_DATA_NS     41000   // 37 us + tADD
+#define LCD_POWERUP_NS  15000000
+#define LCD_PWEH_NS     230
+#define LCD_CYCLE_NS    500
+
+static struct{
+  uint8_t outputs;              // 74HC595 outputs feeding the LCD
+  uint8_t chain;
+  int fourBit;                  // interface length
+  int haveHigh;                 // first nibble of a 4-bit transfer received
+  uint8_t high;
+  int initStep;                 // 8-bit function sets seen
+  uint64_t busyUntil;
+  uint64_t eRise;
+  uint8_t ddram[0x80];
+  uint8_t ac;                   // address counter
+  int increment;
+  int displayOn;
+} Lcd;
+
+static uint8_t NextAddress(uint8_t ac, int inc){
+  if(inc){
+    ac++;
+    if(ac == 0x28) ac = 0x40;
+    if(ac == 0x68) ac = 0x00;
+  } else{
+    if(ac == 0x00) ac = 0x67;
+    else if(ac == 0x40) ac = 0x27;
+    else ac--;
+  }
+  return ac;
+}
+
+static void LcdExecute(uint8_t rs, uint8_t value, uint64_t now){
+  uint64_t ns = LCD_CMD_NS;
+  if(rs){
+    Lcd.ddram[Lcd.ac&0x7F] = value;
+    Lcd.ac = NextAddress(Lcd.ac, Lcd.increment);
+    SimStat.lcdChars++;
+    ns = LCD_DATA_NS;
+  } else{
+    SimStat.lcdCommands++;
+    if(value & 0x80){                       // set DDRAM address
+      Lcd.ac = value&0x7F;
+    } else if(value & 0x40){                // set CGRAM address, not modeled
+    } else if(value & 0x20){                // function set
+      if(!Lcd.fourBit){
+        Lcd.initStep++;
+        if(Lcd.initStep == 1) ns = 4100000; // wait more than 4.1 ms
+        if(Lcd.initStep == 2) ns = 100000;  // wait more than 100 us
+        if((value & 0x10) == 0){
+          Lcd.fourBit = 1;
+          Lcd.haveHigh = 0;
+        }
+      }
+    } else if(value & 0x10){                // cursor or display shift
+      if((value & 0x08) == 0){
+        Lcd.ac = NextAddress(Lcd.ac, value & 0x04);
+      }
+    } else if(value & 0x08){                // display on/off control
+      Lcd.displayOn = (value & 0x04) != 0;
+    } else if(value & 0x04){                // entry mode set
+      Lcd.increment = (value & 0x02) != 0;
+    } else if(value & 0x02){                // return home
+      Lcd.ac = 0;
+      ns = LCD_CLEAR_NS;
+    } else if(value & 0x01){                // clear display
+      memset(Lcd.ddram, ' ', sizeof(Lcd.ddram));
+      Lcd.ac = 0;
+      Lcd.increment = 1;
+      ns = LCD_CLEAR_NS;
+    }
+  }
+  Lcd.busyUntil = now + NsToCycles(ns);
+}
+
+// E fell: the HD44780 takes RS and D7-D4 as they were while E was high
+static void LcdStrobe(uint8_t prev, uint64_t now){
+  uint8_t rs = prev&0x01;
+  uint8_t nibble = prev&0xF0;
+  if(now < NsToCycles(LCD_POWERUP_NS)){
+    SimStat.v.lcdPowerUp++;
+    return;
+  }
+  if(now < Lcd.busyUntil){
+    SimStat.v.lcdBusy++;                    // ignored, as the real part does
+    return;
+  }
+  if(!Lcd.fourBit){
+    LcdExecute(rs, nibble, now);            // D3-D0 are tied low
+  } else if(!Lcd.haveHigh){
+    Lcd.high = nibble;
+    Lcd.haveHigh = 1;
+  } else{
+    Lcd.haveHigh = 0;
+    LcdExecute(rs, Lcd.high|(nibble>>4), now);
+  }
+}
+
+static void LcdLatch(uint64_t now){
+  uint8_t prev = Lcd.outputs;
+  uint8_t next = Lcd.chain;
+  Lcd.outputs = next;
+  if(!(prev&0x02) && (next&0x02)){          // E rises
+    if(now - Lcd.eRise < NsToCycles(LCD_CYCLE_NS)){
+      SimStat.v.lcdPulse++;
+    }
+    if((prev^next)&0x01){
+      SimStat.v.lcdSetup++;
+    }
+    Lcd.eRise = now;
+  } else if((prev&0x02) && !(next&0x02)){   // E falls
+    if(now - Lcd.eRise < NsToCycles(LCD_PWEH_NS)){
+      SimStat.v.lcdPulse++;
+    }
+    if((prev^next)&0xF1){
+      SimStat.lcdHoldRaces++;
+    }
+    LcdStrobe(prev, now);
+  }
+}
+
+//---------- 7-segment display ----------
+static struct{
+  uint16_t chain;
+  uint8_t segments, enables;    // latched outputs
+  uint64_t lastLatch;
+  uint8_t shown[4];
+  uint64_t onCycles[4];
+} Seg;
+
+// Sending segments then enables latches twice, and the first latch briefly
+// shows the new segment byte under the old enables.  Only a pattern that
+// stays up for SEGVISIBLE_NS counts as shown; shorter ones are ghosts.
+#define SEGVISIBLE_NS  100000
+
+static void SegLatch(uint64_t now){
+  int d;
+  int visible = (now - Seg.lastLatch) >= NsToCycles(SEGVISIBLE_NS);
+  for(d = 0; d < 4; d++){                   // account for the old state
+    if(Seg.enables & (0x08>>d)){
+      Seg.onCycles[d] += now - Seg.lastLatch;
+      if(visible){
+        Seg.shown[d] = Seg.segments;
+      }
+    }
+  }
+  Seg.lastLatch = now;
+  Seg.segments = Seg.chain>>8;
+  Seg.enables = Seg.chain&0xFF;
+  SimStat.segLatches++;
+}
+
+//---------- shift registers ----------
+static void ShiftRegistersClock(uint8_t data){
+  Lcd.chain = data;
+  Seg.chain = (Seg.chain<<8)|data;
+}
+
+static void PortCWrite(uint32_t oldv, uint32_t newv, uint64_t now){
+  uint32_t rising = ~oldv & newv;
+  if(rising & 0xC0){
+    if(Ssi.shifting){
+      SimStat.v.latchEarly++;               // latches a half-shifted byte
+    }
+  }
+  if(rising & 0x40){
+    LcdLatch(now);
+  }
+  if(rising & 0x80){
+    SegLatch(now);
+  }
+}
+
+//---------- GPTM ----------
+static const uint32_t TimerBase[12] = {
+  0x40030000, 0x40031000, 0x40032000, 0x40033000, 0x40034000, 0x40035000,
+  0x40036000, 0x40037000, 0x4004C000, 0x4004D000, 0x4004E000, 0x4004F000
+};
+static const int TimerIrq[12] = {19, 21, 23, 35, 70, 92, 94, 96, 98, 100, 102, 104};
+
+static struct{
+  int running;
+  uint64_t start;               // time the current period began
+  uint64_t period;              // cycles from load to timeout
+  uint32_t ris;
+} Timer[12];
+
+static int TimerIndex(uint32_t addr){
+  int i;
+  for(i = 0; i < 12; i++){
+    if((addr&0xFFFFF000) == TimerBase[i]) return i;
+  }
+  return -1;
+}
+
+static uint64_t TimerPeriod(int i){
+  uint32_t base = TimerBase[i];
+  uint32_t load = Sim_Peek(base+TIMER_TAILR);
+  if(Sim_Peek(base+TIMER_CFG) == 4){        // 16-bit, prescaler extends it
+    return (uint64_t)((load&0xFFFF)+1)*((Sim_Peek(base+TIMER_TAPR)&0xFF)+1);
+  }
+  return (uint64_t)load+1;
+}
+
+static void TimerAdvance(int i, uint64_t now){
+  uint32_t mode;
+  while(Timer[i].running && (now >= Timer[i].start + Timer[i].period)){
+    Timer[i].ris |= 0x01;                   // TATORIS
+    mode = Sim_Peek(TimerBase[i]+TIMER_TAMR)&0x3;
+    if(mode == 2){                          // periodic
+      Timer[i].start += Timer[i].period;
+      Timer[i].period = TimerPeriod(i);
+    } else{                                 // one-shot stops, clears TAEN
+      Timer[i].running = 0;
+      Sim_Poke(TimerBase[i]+TIMER_CTL, Sim_Peek(TimerBase[i]+TIMER_CTL)&~0x01);
+    }
+  }
+}
+
+static uint32_t TimerValue(int i, uint64_t now){
+  if(!Timer[i].running){
+    return Sim_Peek(TimerBase[i]+TIMER_TAILR);
+  }
+  return (uint32_t)(Timer[i].period - 1 - (now - Timer[i].start));
+}
+
+//---------- model interface ----------
+static uint64_t ModelNow;
+
+void Model_Reset(void){
+  memset(&Ssi, 0, sizeof(Ssi));
+  memset(&Lcd, 0, sizeof(Lcd));
+  memset(Lcd.ddram, ' ', sizeof(Lcd.ddram));
+  Lcd.increment = 1;
+  Lcd.busyUntil = 0;
+  memset(&Seg, 0, sizeof(Seg));
+  memset(Seg.shown, 0xFF, sizeof(Seg.shown));
+  memset(Timer, 0, sizeof(Timer));
+  Sim_Poke(SYSCTL_RCC2, 0x07C06810);        // reset value, PLL bypassed
+  ModelNow = 0;
+}
+
+void Model_Advance(uint64_t now){
+  int i;
+  ModelNow = now;
+  SsiAdvance(now);
+  for(i = 0; i < 12; i++){
+    TimerAdvance(i, now);
+  }
+}
+
+int Model_Strobe(uint32_t addr, uint32_t *preset){
+  if(addr == SSI2_BASE+SSI_DR){
+    *preset = DR_PRESET;
+    return 1;
+  }
+  if((addr == SSI2_BASE+SSI_ICR) ||
+     ((TimerIndex(addr) >= 0) && ((addr&0xFFF) == TIMER_ICR))){
+    *preset = 0;
+    return 1;
+  }
+  return 0;
+}
+
+void Model_Read(uint32_t addr, uint32_t *val){
+  int i;
+  if((addr >= SYSCTL_PR) && (addr < SYSCTL_PR+0x100)){
+    *val = Sim_Peek(SYSCTL_RCGC+(addr-SYSCTL_PR)); // ready at once
+  } else if(addr == SYSCTL_RIS){
+    *val = 0x40;                            // PLL locked
+  } else if(addr == SYSCTL_PLLSTAT){
+    *val = 0x01;                            // LOCK
+  } else if(addr == SSI2_BASE+SSI_SR){
+    *val = SsiStatus();
+  } else if(addr == SSI2_BASE+SSI_RIS){
+    *val = SsiRaw();
+  } else if(addr == SSI2_BASE+SSI_MIS){
+    *val = SsiRaw()&Sim_Peek(SSI2_BASE+SSI_IM);
+  } else if((i = TimerIndex(addr)) >= 0){
+    switch(addr&0xFFF){
+      case TIMER_RIS: *val = Timer[i].ris; break;
+      case TIMER_MIS: *val = Timer[i].ris&Sim_Peek(TimerBase[i]+TIMER_IMR); break;
+      case TIMER_TAR:
+      case TIMER_TAV: *val = TimerValue(i, ModelNow); break;
+    }
+  }
+}
+
+void Model_Write(uint32_t addr, uint32_t oldv, uint32_t newv){
+  int i;
+  if(addr == SYSCTL_RCC2){
+    if(newv&0x80000000){                    // USERCC2; RCC isn't modeled
+      Sim_SetBusHz((newv&0x00002800) ? 16000000 : // BYPASS2 or PWRDN2
+                   400000000/(((newv>>22)&0x7F) + 1));
+    }
+  } else if(addr == GPIO_PORTC_DATA){
+    PortCWrite(oldv, newv, ModelNow);
+  } else if(addr == SSI2_BASE+SSI_DR){
+    SsiPush((uint8_t)newv, ModelNow);
+  } else if(addr == SSI2_BASE+SSI_CR1){
+    if(!(oldv&0x02) && (newv&0x02) && Ssi.count && !Ssi.shifting){
+      SsiStart(ModelNow);
+    }
+  } else if((i = TimerIndex(addr)) >= 0){
+    switch(addr&0xFFF){
+      case TIMER_CTL:
+        if(!(oldv&0x01) && (newv&0x01)){    // TAEN set: load and start
+          Timer[i].running = 1;
+          Timer[i].start = ModelNow;
+          Timer[i].period = TimerPeriod(i);
+        } else if((oldv&0x01) && !(newv&0x01)){
+          Timer[i].running = 0;
+        }
+        break;
+      case TIMER_ICR:
+        Timer[i].ris &= ~newv;
+        break;
+    }
+  }
+}
+
+int Model_IrqPending(int irq){
+  int i;
+  if(irq == 57){
+    return (SsiRaw()&Sim_Peek(SSI2_BASE+SSI_IM)) != 0;
+  }
+  for(i = 0; i < 12; i++){
+    if(TimerIrq[i] == irq){
+      return (Timer[i].ris&Sim_Peek(TimerBase[i]+TIMER_IMR)) != 0;
+    }
+  }
+  return 0;
+}
+
+//---------- results ----------
+void Sim_LCDLine(int line, char *buf){
+  int i;
+  uint8_t c;
+  for(i = 0; i < 16; i++){
+    c = Lcd.ddram[(line ? 0x40 : 0x00) + i];
+    buf[i] = ((c >= 0x20) && (c < 0x7F)) ? c : '?';
+  }
+  buf[16] = 0;
+}
+
+uint8_t Sim_SegDigit(int digit){
+  if((Seg.enables & (0x08>>(digit&3))) &&
+     ((Sim_Now() - Seg.lastLatch) >= NsToCycles(SEGVISIBLE_NS))){
+    return Seg.segments;                    // still up since the last latch
+  }
+  return Seg.shown[digit&3];
+}
+
+uint64_t Sim_SegOnCycles(int digit){
+  return Seg.onCycles[digit&3];
+}
+
+void Sim_Report(FILE *fp, const struct SimStats *base){
+  struct SimStats st;
+  uint64_t elapsed;
+  double seconds;
+  Sim_GetStats(&st);
+  elapsed = st.cycles - base->cycles;
+  seconds = (double)elapsed/Sim_BusHz();
+  st.lcdChars -= base->lcdChars;
+  st.lcdCommands -= base->lcdCommands;
+  fprintf(fp, "bus_hz=%u\n", Sim_BusHz());
+  fprintf(fp, "elapsed_us=%.1f\n", seconds*1e6);
+  fprintf(fp, "lcd_chars=%u\n", st.lcdChars);
+  fprintf(fp, "lcd_commands=%u\n", st.lcdCommands);
+  fprintf(fp, "lcd_chars_per_s=%.0f\n", seconds > 0 ? st.lcdChars/seconds : 0.0);
+  fprintf(fp, "ssi_frames=%u\n", st.ssiFrames - base->ssiFrames);
+  fprintf(fp, "ssi_bus_util_pct=%.2f\n", elapsed ? 100.0*(st.ssiBusyCycles - base->ssiBusyCycles)/elapsed : 0.0);
+  fprintf(fp, "cpu_idle_pct=%.2f\n", elapsed ? 100.0*(st.idleCycles - base->idleCycles)/elapsed : 0.0);
+  fprintf(fp, "cpu_isr_pct=%.2f\n", elapsed ? 100.0*(st.isrCycles - base->isrCycles)/elapsed : 0.0);
+  fprintf(fp, "interrupts=%u\n", st.interrupts - base->interrupts);
+  fprintf(fp, "seg_latches=%u\n", st.segLatches - base->segLatches);
+  fprintf(fp, "lcd_hold_races=%u\n", st.lcdHoldRaces);
+  fprintf(fp, "viol_lcd_busy=%u\n", st.v.lcdBusy);
+  fprintf(fp, "viol_lcd_powerup=%u\n", st.v.lcdPowerUp);
+  fprintf(fp, "viol_lcd_pulse=%u\n", st.v.lcdPulse);
+  fprintf(fp, "viol_lcd_setup=%u\n", st.v.lcdSetup);
+  fprintf(fp, "viol_latch_early=%u\n", st.v.latchEarly);
+  fprintf(fp, "viol_fifo_overrun=%u\n", st.v.fifoOverrun);
+  fprintf(fp, "viol_irq_stuck=%u\n", st.v.irqStuck);
+}
@@ -0,0 +1,45 @@
+// kernel.c
+// Runs on the host (Linux, gcc)
+// The drivers call into os.c for blocking waits.  There is no scheduler
+// on the host, so OS_Running() is 0 and the drivers take their
+// single-thread paths; the rest only has to link.
+// The governor measures its load off OS_IdleCycles and BSP_Cycles; idle
+// is the time spent in WFI and sleeps, as in the kernel's idle thread.
+
+#include <stdint.h>
+#include "os.h"
+#include "BSP.h"
+#include "sim.h"
+
+int OS_Running(void){
+  return 0;
+}
+
+void OS_Suspend(void){
+}
+
+void OS_InitSemaphore(int32_t *semaPt, int32_t value){
+  *semaPt = value;
+}
+
+void OS_Wait(int32_t *semaPt){
+  (*semaPt)--;
+}
+
+void OS_Signal(int32_t *semaPt){
+  (*semaPt)++;
+}
+
+void OS_Sleep(uint32_t sleepTime){
+  Sim_Idle(sleepTime*(Sim_BusHz()/1000));
+}
+
+uint32_t OS_IdleCycles(void){
+  Sim_Flush();
+  return (uint32_t)SimStat.idleCycles;
+}
+
+uint32_t BSP_Cycles(void){
+  Sim_Flush();
+  return (uint32_t)Sim_Now();
+}
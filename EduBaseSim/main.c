@@ -0,0 +1,152 @@
+// main.c
+// Runs on the host (Linux, gcc)
+// Display workload for the EduBase-V2 model: brings up SSI2, Timer0A and
+// the LCD with the LaunchPad drivers, queues both lines, redraws them
+// through the shadow framebuffer with one digit changed, then scans the
+// 7-segment display.  The report rates cover the LCD text only.
+// Last, the bus clock governor runs a heavy load, which it has to step
+// up to a clock that keeps up with, then a light one, which it has to
+// step back down to the slowest clock for.
+// "edubase_sim --check" exits with status 1 on any timing violation or
+// a governor that didn't follow the load.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "tm4c_sim.h"
+#include "sim.h"
+#include "SSI2.h"
+#include "Clock.h"
+#include "PLL.h"
+#include "Timer0A.h"
+#include "LCD.h"
+#include "Governor.h"
+
+void EnableInterrupts(void);   // sim.c
+
+#define BUSHZ     8000000      // Bus8MHz, as set by BSP_Init and PLL_Init below
+#define SEGSCANS  25           // passes over the four digits, 100 ms
+#define GOVHEAVY  20000        // bus cycles of work per ms, 20 MHz worth
+#define GOVLIGHT  400          // 0.4 MHz worth
+#define GOVUP     10           // heavy windows, 4 steps up from 8 MHz
+#define GOVDOWN   30           // light windows, 6 steps down held 3 each
+#define GOVSLOWEST 4000000     // last clock of the governor's table
+
+// PC7 chip select for the 7-segment shift registers, as in SevenSeg_Init
+static void SevenSegCS_Init(void){
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTC);
+  GPIO_PORTC_AMSEL_R &= ~0x80; // disable analog of PORTC 7
+  GPIO_PORTC_DATA_R |= 0x80;   // set PORTC 7 idle high
+  GPIO_PORTC_DIR_R |= 0x80;    // set PORTC 7 as output for CS
+  GPIO_PORTC_DEN_R |= 0x80;    // set PORTC 7 as digital pin
+}
+
+// one governor window: work bus cycles of register accesses every ms,
+// asleep in Timer0A for the rest of it; the same work takes longer at
+// a slower clock, and an ms it overruns isn't slept at all
+static void GovWindow(uint32_t work){
+  uint32_t ms, n, period;
+  uint64_t start;
+  for(ms = 0; ms < GOVERNOR_WINDOW_MS; ms++){
+    start = Sim_Now();
+    for(n = 0; n < work/SIM_ACCESS_CYCLES; n++){
+      (void)GPIO_PORTF_DATA_R;
+    }
+    period = PLL_BusClock()/1000;
+    if(Sim_Now() - start < period){
+      Timer0A_Wait(period - (uint32_t)(Sim_Now() - start));
+    }
+  }
+  Governor_Sample();
+}
+
+int main(int argc, char **argv){
+  int check = (argc > 1) && (strcmp(argv[1], "--check") == 0);
+  char line[17];
+  struct SimStats t0;
+  struct SimStats before, after;
+  uint32_t upHz, downHz;
+  int i, d, govOk;
+
+  Sim_Init(BUSHZ);
+  PLL_Init(Bus8MHz);           // records the clock the drivers scale to
+  SSI2_init();                 // for the 7-segment; LCD_init adds itself
+  Timer0A_Init();
+  SevenSegCS_Init();
+  EnableInterrupts();          // SSI2 transfers run from SSI2_Handler
+  LCD_init();
+
+  Sim_GetStats(&t0);           // rates cover the text, not LCD_init
+  LCD_OutString((uint8_t *)"EduBase sim");
+  LCD_command(0xC0);           // second line
+  LCD_OutUDec(1234567);
+  LCD_OutString((uint8_t *)" ");
+  LCD_OutUHex(0xBEEF);
+  LCD_Flush();                 // the queue drains in the background
+  Sim_Report(stdout, &t0);
+  printf("lcd_max_depth=%u\n", LCD_MaxDepth);
+  printf("lcd_dropped=%u\n", LCD_Dropped);
+
+  LCD_Clear();                 // same text through the shadow
+  LCD_DrawString("EduBase sim");
+  LCD_Goto(1, 0);
+  LCD_DrawUDec(1234567, 7);
+  LCD_DrawString(" BEEF");
+  LCD_Refresh();
+  LCD_Flush();
+  LCD_Goto(0, 0);              // full redraw, one digit differs
+  LCD_DrawString("EduBase sim");
+  LCD_Goto(1, 0);
+  LCD_DrawUDec(1234568, 7);
+  LCD_DrawString(" BEEF");
+  Sim_GetStats(&before);
+  LCD_Refresh();
+  LCD_Flush();
+  Sim_GetStats(&after);
+  printf("redraw_chars=%u\n", after.lcdChars - before.lcdChars);
+  printf("redraw_commands=%u\n", after.lcdCommands - before.lcdCommands);
+
+  for(i = 0; i < SEGSCANS; i++){
+    for(d = 0; d < 4; d++){
+      displayDigit((uint8_t)(d+1), (uint8_t)d);
+      Timer0A_Wait1ms(1);      // multiplex at 250 Hz per digit
+    }
+  }
+
+  for(i = 0; i < 2; i++){
+    Sim_LCDLine(i, line);
+    printf("lcd_line%d=\"%s\"\n", i, line);
+  }
+  printf("seg_digits=");
+  for(d = 0; d < 4; d++){
+    printf("%02X%s", Sim_SegDigit(d), d < 3 ? "," : "\n");
+  }
+  printf("seg_on_us=");
+  for(d = 0; d < 4; d++){
+    printf("%llu%s", (unsigned long long)(Sim_SegOnCycles(d)*1000000/BUSHZ), d < 3 ? "," : "\n");
+  }
+
+  Governor_Start();
+  for(i = 0; i < GOVUP; i++){
+    GovWindow(GOVHEAVY);
+  }
+  upHz = PLL_BusClock();
+  printf("gov_heavy_hz=%u\n", upHz);
+  printf("gov_heavy_load_pct=%u\n", Governor_Load);
+  for(i = 0; i < GOVDOWN; i++){
+    GovWindow(GOVLIGHT);
+  }
+  downHz = PLL_BusClock();
+  printf("gov_light_hz=%u\n", downHz);
+  printf("gov_light_load_pct=%u\n", Governor_Load);
+  printf("gov_steps=%u\n", Governor_Steps);
+  govOk = ((uint64_t)upHz*GOVERNOR_UP >= (uint64_t)GOVHEAVY*1000*100) &&
+          (downHz == GOVSLOWEST);
+  printf("gov_ok=%d\n", govOk);
+
+  printf("violations=%u\n", Sim_Violations());
+  if(check && (Sim_Violations() || !govOk)){
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,323 @@
+// sim.c
+// Runs on the host (Linux, gcc)
+// Register file, access sequencing, simulated clock, NVIC and PRIMASK
+// for the virtual TM4C123.  The peripherals themselves are in edubase.c.
+//
+// A register macro expands to (*Sim_Reg(addr)), so the model learns about
+// an access when it happens but only sees a store's value at the next
+// access.  Each call therefore first commits the previous access (compares
+// the stored value with what was there), then advances time, then lets
+// pending interrupts run, then hands out the storage for the new access.
+// Write-triggered registers (SSI2_DR, ICR, NVIC set/clear) are preset to a
+// value software never writes, so repeated identical stores are not lost.
+
+#include <stdint.h>
+#include <string.h>
+#include "sim.h"
+
+#define NUMSLOTS 4096          // power of 2, registers touched by a program
+
+struct slot{
+  uint32_t addr;
+  uint32_t used;
+  uint32_t val;
+};
+static struct slot Slots[NUMSLOTS];
+
+struct SimStats SimStat;
+static uint64_t Now;            // bus cycles
+static uint32_t BusHz;
+
+static uint32_t *PendVal;       // storage handed out by the last Sim_Reg
+static uint32_t PendAddr;
+static uint32_t PendOld;
+static int Pending;
+
+static uint32_t Primask;        // 1 = interrupts disabled, as after reset
+static int InISR;
+static int ActiveIrq;           // IRQ being serviced while InISR
+static uint32_t NvicEnabled[5]; // NVIC_EN0-4
+static uint32_t NvicPending[5]; // software pended (NVIC_PEND, NVIC_SW_TRIG)
+
+// handlers the drivers may define; unresolved weak symbols are NULL
+#define WEAK __attribute__((weak))
+extern void SSI2_Handler(void) WEAK;
+extern void uDMA_Handler(void) WEAK;
+extern void Timer0A_Handler(void) WEAK;
+extern void Timer1A_Handler(void) WEAK;
+extern void Timer2A_Handler(void) WEAK;
+extern void Timer3A_Handler(void) WEAK;
+extern void Timer4A_Handler(void) WEAK;
+extern void Timer5A_Handler(void) WEAK;
+extern void WideTimer0A_Handler(void) WEAK;
+extern void WideTimer1A_Handler(void) WEAK;
+extern void WideTimer2A_Handler(void) WEAK;
+extern void WideTimer3A_Handler(void) WEAK;
+extern void WideTimer4A_Handler(void) WEAK;
+extern void WideTimer5A_Handler(void) WEAK;
+
+struct vector{
+  int irq;
+  void (*handler)(void);
+};
+// in priority order, the NVIC's tie-break is the lower number
+static const struct vector Vectors[] = {
+  {19, Timer0A_Handler},
+  {21, Timer1A_Handler},
+  {23, Timer2A_Handler},
+  {35, Timer3A_Handler},
+  {46, uDMA_Handler},
+  {57, SSI2_Handler},
+  {70, Timer4A_Handler},
+  {92, Timer5A_Handler},
+  {94, WideTimer0A_Handler},
+  {96, WideTimer1A_Handler},
+  {98, WideTimer2A_Handler},
+  {100, WideTimer3A_Handler},
+  {102, WideTimer4A_Handler},
+  {104, WideTimer5A_Handler},
+};
+#define NUMVECTORS (sizeof(Vectors)/sizeof(Vectors[0]))
+
+static struct slot *Lookup(uint32_t addr){
+  uint32_t i = (addr>>2)&(NUMSLOTS-1);
+  while(Slots[i].used && (Slots[i].addr != addr)){
+    i = (i+1)&(NUMSLOTS-1);
+  }
+  if(!Slots[i].used){
+    Slots[i].used = 1;
+    Slots[i].addr = addr;
+    Slots[i].val = 0;
+  }
+  return &Slots[i];
+}
+
+uint32_t Sim_Peek(uint32_t addr){
+  return Lookup(addr)->val;
+}
+
+void Sim_Poke(uint32_t addr, uint32_t val){
+  Lookup(addr)->val = val;
+}
+
+//---------- Cortex-M core registers handled here ----------
+#define NVIC_EN0      0xE000E100
+#define NVIC_DIS0     0xE000E180
+#define NVIC_PEND0    0xE000E200
+#define NVIC_UNPEND0  0xE000E280
+#define NVIC_SW_TRIG  0xE000EF00
+#define NVIC_INT_CTRL 0xE000ED04
+
+static int CoreStrobe(uint32_t addr, uint32_t *preset){
+  if(((addr >= NVIC_EN0) && (addr < NVIC_EN0+0x14)) ||
+     ((addr >= NVIC_DIS0) && (addr < NVIC_DIS0+0x14))){
+    *preset = 0;                // reads back the enable bits, see CoreRead
+    return 1;
+  }
+  if(((addr >= NVIC_PEND0) && (addr < NVIC_PEND0+0x14)) ||
+     ((addr >= NVIC_UNPEND0) && (addr < NVIC_UNPEND0+0x14)) ||
+     (addr == NVIC_SW_TRIG)){
+    *preset = 0;
+    return 1;
+  }
+  return Model_Strobe(addr, preset);
+}
+
+static void CoreRead(uint32_t addr, uint32_t *val){
+  if((addr >= NVIC_EN0) && (addr < NVIC_EN0+0x14)){
+    *val = NvicEnabled[(addr-NVIC_EN0)/4];
+  } else if((addr >= NVIC_DIS0) && (addr < NVIC_DIS0+0x14)){
+    *val = NvicEnabled[(addr-NVIC_DIS0)/4];
+  } else if(addr == NVIC_INT_CTRL){
+    *val = InISR ? (ActiveIrq+16) : 0;  // VECTACTIVE, handler mode test
+  } else{
+    Model_Read(addr, val);
+  }
+}
+
+static void CoreWrite(uint32_t addr, uint32_t oldv, uint32_t newv){
+  if((addr >= NVIC_EN0) && (addr < NVIC_EN0+0x14)){
+    NvicEnabled[(addr-NVIC_EN0)/4] |= newv;
+  } else if((addr >= NVIC_DIS0) && (addr < NVIC_DIS0+0x14)){
+    NvicEnabled[(addr-NVIC_DIS0)/4] &= ~newv;
+  } else if((addr >= NVIC_PEND0) && (addr < NVIC_PEND0+0x14)){
+    NvicPending[(addr-NVIC_PEND0)/4] |= newv;
+  } else if((addr >= NVIC_UNPEND0) && (addr < NVIC_UNPEND0+0x14)){
+    NvicPending[(addr-NVIC_UNPEND0)/4] &= ~newv;
+  } else if(addr == NVIC_SW_TRIG){
+    NvicPending[(newv&0xFF)/32] |= 1u<<((newv&0xFF)%32);
+  } else{
+    Model_Write(addr, oldv, newv);
+  }
+}
+
+static void Advance(uint64_t cycles){
+  Now += cycles;
+  Model_Advance(Now);
+}
+
+// run every handler whose interrupt is enabled and asserted
+static void Dispatch(void){
+  uint32_t i;
+  int irq;
+  uint64_t start;
+  if(Primask || InISR){
+    return;
+  }
+  for(i = 0; i < NUMVECTORS; i++){
+    irq = Vectors[i].irq;
+    if(((NvicEnabled[irq/32]>>(irq%32))&1) == 0){
+      continue;
+    }
+    if((((NvicPending[irq/32]>>(irq%32))&1) == 0) && !Model_IrqPending(irq)){
+      continue;
+    }
+    NvicPending[irq/32] &= ~(1u<<(irq%32));
+    if(Vectors[i].handler == NULL){
+      continue;
+    }
+    start = Now;
+    InISR = 1;
+    ActiveIrq = irq;
+    Advance(12);                // exception entry
+    Vectors[i].handler();
+    Sim_Flush();
+    Advance(12);                // exception return
+    InISR = 0;
+    SimStat.isrCycles += Now - start;
+    SimStat.interrupts++;
+    if(Model_IrqPending(irq)){
+      SimStat.v.irqStuck++;
+    }
+  }
+}
+
+void Sim_Flush(void){
+  if(Pending){
+    Pending = 0;
+    if(*PendVal != PendOld){
+      CoreWrite(PendAddr, PendOld, *PendVal);
+    }
+  }
+}
+
+volatile uint32_t *Sim_Reg(uint32_t addr){
+  struct slot *s;
+  uint32_t preset;
+  Sim_Flush();
+  Advance(SIM_ACCESS_CYCLES);
+  Dispatch();
+  s = Lookup(addr);
+  if(CoreStrobe(addr, &preset)){
+    s->val = preset;
+  } else{
+    CoreRead(addr, &s->val);
+  }
+  PendVal = &s->val;
+  PendAddr = addr;
+  PendOld = s->val;
+  Pending = 1;
+  return PendVal;
+}
+
+void Sim_Idle(uint32_t cycles){
+  uint64_t start;
+  Sim_Flush();
+  while(cycles){
+    uint32_t step = cycles < SIM_ACCESS_CYCLES ? cycles : SIM_ACCESS_CYCLES;
+    start = Now;
+    Advance(step);
+    SimStat.idleCycles += Now - start;
+    cycles -= step;
+    Dispatch();
+  }
+}
+
+void Sim_Init(uint32_t busHz){
+  memset(Slots, 0, sizeof(Slots));
+  memset(&SimStat, 0, sizeof(SimStat));
+  memset(NvicEnabled, 0, sizeof(NvicEnabled));
+  memset(NvicPending, 0, sizeof(NvicPending));
+  Now = 0;
+  BusHz = busHz;
+  Pending = 0;
+  Primask = 1;
+  InISR = 0;
+  Model_Reset();
+}
+
+uint64_t Sim_Now(void){
+  return Now;
+}
+
+uint32_t Sim_BusHz(void){
+  return BusHz;
+}
+
+void Sim_SetBusHz(uint32_t busHz){
+  BusHz = busHz;
+}
+
+void Sim_GetStats(struct SimStats *st){
+  Sim_Flush();
+  *st = SimStat;
+  st->cycles = Now;
+}
+
+uint32_t Sim_Violations(void){
+  struct SimViolations *v = &SimStat.v;
+  return v->lcdBusy + v->lcdPowerUp + v->lcdPulse + v->lcdSetup +
+         v->latchEarly + v->fifoOverrun + v->irqStuck;
+}
+
+//---------- processor intrinsics normally in the startup file ----------
+
+void DisableInterrupts(void){
+  Sim_Flush();
+  Primask = 1;
+}
+
+void EnableInterrupts(void){
+  Sim_Flush();
+  Primask = 0;
+  Dispatch();
+}
+
+uint32_t StartCritical(void){
+  uint32_t sr = Primask;
+  Sim_Flush();
+  Primask = 1;
+  return sr;
+}
+
+void EndCritical(uint32_t sr){
+  Sim_Flush();
+  Primask = sr;
+  Dispatch();
+}
+
+// 1 if an enabled interrupt is asserted, whether or not PRIMASK masks it
+static int IrqReady(void){
+  uint32_t i;
+  int irq;
+  for(i = 0; i < NUMVECTORS; i++){
+    irq = Vectors[i].irq;
+    if(((NvicEnabled[irq/32]>>(irq%32))&1) &&
+       (((NvicPending[irq/32]>>(irq%32))&1) || Model_IrqPending(irq))){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// sleep until a handler has run or, with PRIMASK set, one is waiting
+// to run (WFI wakes either way); give up after one simulated second
+void WaitForInterrupt(void){
+  uint32_t count = SimStat.interrupts;
+  uint64_t limit = Now + BusHz;
+  Sim_Flush();
+  while((SimStat.interrupts == count) && !(Primask && IrqReady()) &&
+        (Now < limit)){
+    Sim_Idle(SIM_ACCESS_CYCLES);
+  }
+}
@@ -0,0 +1,141 @@
+// sim.h
+// Runs on the host (Linux, gcc)
+// Virtual TM4C123 + EduBase-V2 peripheral model.
+// The driver sources in ../RTOS_TivaC are compiled unmodified against a
+// copy of tm4c123gh6pm.h in which every register macro calls Sim_Reg()
+// (see tm4c_sim.h and the Makefile).  Simulated time is counted in bus
+// cycles and only advances when the code touches a register or idles, so
+// busy-wait loops make progress exactly as they would on the LaunchPad.
+//
+// Modeled: SSI2 (8-entry TX FIFO, BSY, TX interrupt, EOT), the 74HC595
+// shift registers latched by PC6 (LCD) and PC7 (two for the 7-segment
+// display), an HD44780 with datasheet command timing, GPTM Timer0-5 and
+// WTimer0-5 one-shot/periodic timeouts, NVIC enables and PRIMASK, and
+// the bus clock PLL_SetFrequency sets through RCC2.
+// MOSI and SCLK go to every shift register; the chip selects only latch.
+
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SIM_ACCESS_CYCLES  4     // cost of one register access (ldr/str + loop)
+
+// violation counters, see Sim_Report
+struct SimViolations{
+  uint32_t lcdBusy;       // HD44780 written while executing a command
+  uint32_t lcdPowerUp;    // HD44780 written before its 15 ms power-on delay
+  uint32_t lcdPulse;      // E high shorter than 230 ns or cycle under 500 ns
+  uint32_t lcdSetup;      // RS changed in the same latch that raised E
+  uint32_t latchEarly;    // chip select raised while SSI2 was still shifting
+  uint32_t fifoOverrun;   // write to SSI2_DR with the TX FIFO full
+  uint32_t irqStuck;      // handler returned without clearing its source
+};
+
+struct SimStats{
+  uint64_t cycles;        // bus cycles since Sim_Init
+  uint64_t idleCycles;    // cycles spent in Sim_Idle (WFI, blocked threads)
+  uint64_t isrCycles;     // cycles spent inside interrupt handlers
+  uint64_t ssiBusyCycles; // cycles SSI2 spent shifting frames
+  uint32_t ssiFrames;     // frames shifted out of SSI2
+  uint32_t lcdChars;      // characters written into DDRAM
+  uint32_t lcdCommands;   // instructions executed
+  uint32_t lcdHoldRaces;  // RS/data changed in the latch that dropped E
+  uint32_t segLatches;    // PC7 rising edges
+  uint32_t interrupts;    // handlers dispatched
+  struct SimViolations v;
+};
+
+// ******** Sim_Init ************
+// power-on reset of every model; time starts at 0
+// Inputs: bus clock in Hz
+// Outputs: none
+void Sim_Init(uint32_t busHz);
+
+// ******** Sim_Reg ************
+// the register access hook used by the generated tm4c123gh6pm.h
+// commits the previous access, advances time, dispatches interrupts
+// and returns the storage for this access
+// Inputs: register address
+// Outputs: pointer to the register value
+volatile uint32_t *Sim_Reg(uint32_t addr);
+
+// ******** Sim_Idle ************
+// let time pass with the CPU asleep (WFI or a blocked thread)
+// interrupts are dispatched as they become pending
+// Inputs: number of bus cycles
+// Outputs: none
+void Sim_Idle(uint32_t cycles);
+
+// ******** Sim_Flush ************
+// commit the last register access (call before reading results)
+void Sim_Flush(void);
+
+// current time in bus cycles
+uint64_t Sim_Now(void);
+
+// bus clock in Hz
+uint32_t Sim_BusHz(void);
+
+// new bus clock (the RCC2 model); time stays in bus cycles, so a
+// nanosecond is then more or fewer of them
+void Sim_SetBusHz(uint32_t busHz);
+
+// snapshot of the counters
+void Sim_GetStats(struct SimStats *st);
+
+// total of the timing violation counters
+uint32_t Sim_Violations(void);
+
+// ******** Sim_LCDLine ************
+// visible contents of one LCD line
+// Inputs: line 0 or 1, buffer of at least 17 characters
+// Outputs: none
+void Sim_LCDLine(int line, char *buf);
+
+// ******** Sim_SegDigit ************
+// last pattern held on one 7-segment digit for at least 100 us
+// Inputs: digit 0 (left) to 3
+// Outputs: active-low segment pattern, 0xFF when never lit
+uint8_t Sim_SegDigit(int digit);
+
+// time the digit was lit, in bus cycles
+uint64_t Sim_SegOnCycles(int digit);
+
+// ******** Sim_Report ************
+// print the counters as key=value lines; activity is counted from a
+// snapshot taken with Sim_GetStats, violations from Sim_Init
+// Inputs: output stream, snapshot at the start of the measurement
+// Outputs: none
+void Sim_Report(FILE *fp, const struct SimStats *base);
+
+//---------- interface between sim.c and the peripheral models ----------
+
+// refresh the value software will read from a model-owned register
+void Model_Read(uint32_t addr, uint32_t *val);
+
+// value a strobe register (DR, ICR, W1S) holds before software writes it
+// returns 1 with *preset set if addr is a strobe register
+int Model_Strobe(uint32_t addr, uint32_t *preset);
+
+// software wrote newv into addr (oldv is what it held before)
+void Model_Write(uint32_t addr, uint32_t oldv, uint32_t newv);
+
+// bring the peripherals up to time now
+void Model_Advance(uint64_t now);
+
+// 1 if peripheral interrupt irq is asserted (before NVIC masking)
+int Model_IrqPending(int irq);
+
+void Model_Reset(void);
+
+// value last stored in a register, without side effects or time
+uint32_t Sim_Peek(uint32_t addr);
+
+// change a register from the hardware side (e.g. one-shot clears TAEN)
+void Sim_Poke(uint32_t addr, uint32_t val);
+
+extern struct SimStats SimStat;
+
+#endif
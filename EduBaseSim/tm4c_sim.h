@@ -0,0 +1,21 @@
+// tm4c_sim.h
+// Runs on the host (Linux, gcc)
+// Forced into every driver source with -include (see Makefile).
+// Pulls in build/tm4c123gh6pm.h, a copy of the TI header in which
+// (*((volatile uint32_t *)0x...)) became (*Sim_Reg(0x...)).  It carries the
+// same include guard, so the driver's own #include "tm4c123gh6pm.h" is
+// then empty and every register access goes through the model.
+
+#ifndef __TM4C_SIM_H__
+#define __TM4C_SIM_H__
+
+#include <stdint.h>
+
+volatile uint32_t *Sim_Reg(uint32_t addr);
+
+// drivers that compute register addresses (Timer.c) go through HWREG
+#define HWREG(addr) (*Sim_Reg(addr))
+
+#include "build/tm4c123gh6pm.h"
+
+#endif
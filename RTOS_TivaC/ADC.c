@@ -0,0 +1,200 @@
+// ADC.c
+// Runs on TM4C123
+// Timer-paced ADC0 sampling into uDMA ping-pong buffers, see ADC.h.
+// The last step of the sequence requests the uDMA (IE), which moves the
+// whole sequence in one arbitration; ADCIM stays 0, so the only
+// interrupt is the uDMA's buffer-done, which the uDMA signals on the
+// sequencer's vector.  There uDMA_Complete re-arms the buffer and calls
+// Full, which signals the waiting thread.
+// Overruns: when a buffer completes, the other one is about to be
+// refilled; if the thread still has it (or hasn't taken the previous
+// signal) that data is lost, and the overrun is counted.
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "ADC.h"
+#include "PLL.h"
+#include "Timer.h"
+#include "uDMA.h"
+#include "Clock.h"
+#include "os.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+void WaitForInterrupt(void);     // low power mode
+
+#define ADC_TIMER TIMER_2
+
+// AIN0-11: GPIO port (clock bit, 0 = A) and pin
+static const uint8_t Port[12] = {4, 4, 4, 4, 3, 3, 3, 3, 4, 4, 1, 1};
+static const uint8_t Pin[12]  = {3, 2, 1, 0, 3, 2, 1, 0, 5, 4, 4, 5};
+static const uint32_t PortBase[6] = {
+  0x40004000, 0x40005000, 0x40006000, 0x40007000, 0x40024000, 0x40025000
+};
+// GPIO register offsets
+#define GPIO_AFSEL 0x420
+#define GPIO_DEN   0x51C
+#define GPIO_AMSEL 0x528
+#define GPIO_DIR   0x400
+
+#ifndef HWREG
+#define HWREG(addr) (*((volatile uint32_t *)(addr)))
+#endif
+
+static uint16_t Buf[2][ADC_BUFSIZE];
+static uint32_t Count;          // samples per buffer
+static volatile uint8_t Filled; // the buffer that completed last
+static volatile uint8_t Taken;  // the buffer the thread has, 2 for none
+static int32_t Ready;           // signaled once per full buffer
+static uint32_t Ports;          // GPIO ports acquired for the inputs
+volatile uint32_t ADC_Buffers, ADC_Overruns, ADC_FifoOverflows;
+
+// uDMA finished a buffer, in ADC0Seq0_Handler
+static void Full(uint32_t channel, uint32_t alt){
+  ADC_Buffers++;
+  if((Taken == (alt^1)) || (Ready > 0)){
+    ADC_Overruns++;             // the other one is being refilled now
+  }
+  Filled = alt;
+  if(Ready <= 0){
+    OS_Signal(&Ready);
+  }
+}
+
+void ADC0Seq0_Handler(void){
+  if(ADC0_OSTAT_R&ADC_OSTAT_OV0){
+    ADC0_OSTAT_R = ADC_OSTAT_OV0;       // write 1 to clear
+    ADC_FifoOverflows++;
+  }
+  ADC0_ISC_R = ADC_ISC_IN0;
+  uDMA_Complete(1u<<UDMA_ADC0SS0);
+}
+
+// log2 of a power of 2 up to 64, -1 if not one
+static int Log2(uint32_t n){
+  int i;
+  for(i = 0; i <= 6; i++){
+    if(n == (1u<<i)){
+      return i;
+    }
+  }
+  return -1;
+}
+
+// ******** ADC_Open ************
+// set up the input pins, the sequencer, the uDMA and Timer2A, and
+// start sampling; ADC_Wait hands out the buffers
+// each conversion takes 1 us times the oversampling, so inputs *
+// oversample * rate must stay under 1000000
+// Inputs: analog input numbers (0 to 11 for AIN0-AIN11), how many (1,
+//         2, 4 or 8), sequences per second, hardware averaging over 1,
+//         2, 4, 8, 16, 32 or 64 conversions
+// Outputs: 1 if started, 0 on a bad argument or Timer2 taken
+int ADC_Open(const uint8_t *inputs, uint32_t n, uint32_t rate,
+             uint32_t oversample){
+  int arb = Log2(n), sac = Log2(oversample);
+  uint32_t i, mux = 0, base, bit;
+  if((arb < 0) || (n > 8) || (sac < 0) || (rate == 0) ||
+     ((uint64_t)n*oversample*rate >= 1000000)){
+    return 0;
+  }
+  for(i = 0; i < n; i++){
+    if(inputs[i] > 11){
+      return 0;
+    }
+  }
+  if(!Timer_Open(ADC_TIMER, "ADC")){
+    return 0;
+  }
+  uDMA_Init();
+  Clock_Acquire(CLOCK_ADC, 0);
+  Ports = 0;
+  for(i = 0; i < n; i++){               // analog function on the pins
+    base = PortBase[Port[inputs[i]]];
+    bit = 1u<<Pin[inputs[i]];
+    if((Ports&(1u<<Port[inputs[i]])) == 0){
+      Ports |= 1u<<Port[inputs[i]];     // one user per port
+      Clock_Acquire(CLOCK_GPIO, Port[inputs[i]]);
+    }
+    HWREG(base+GPIO_DIR) &= ~bit;
+    HWREG(base+GPIO_AFSEL) |= bit;
+    HWREG(base+GPIO_DEN) &= ~bit;
+    HWREG(base+GPIO_AMSEL) |= bit;
+    mux |= (uint32_t)inputs[i]<<(4*i);
+  }
+
+  Count = (ADC_BUFSIZE/n)*n;            // whole sequences per buffer
+  Taken = 2;
+  Filled = 0;
+  OS_InitSemaphore(&Ready, 0);
+  ADC_Buffers = ADC_Overruns = ADC_FifoOverflows = 0;
+
+  ADC0_PC_R = ADC_PC_SR_1M;
+  ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN0;     // disable SS0 during setup
+  ADC0_EMUX_R = (ADC0_EMUX_R&~0x000F)|ADC_EMUX_EM0_TIMER;
+  ADC0_SSMUX0_R = mux;
+  ADC0_SSCTL0_R = 0x6u<<(4*(n-1));      // END and IE on the last step
+  ADC0_SAC_R = sac;                     // average 2^sac conversions
+  ADC0_IM_R &= ~ADC_IM_MASK0;           // no interrupt per sequence
+  ADC0_ISC_R = ADC_ISC_IN0;
+  ADC0_OSTAT_R = ADC_OSTAT_OV0;
+  NVIC_PRI3_R = (NVIC_PRI3_R&0xFF1FFFFF)|(ADC_PRI<<21); // IRQ 14
+  NVIC_EN0_R = 1<<14;
+
+  uDMA_Assign(UDMA_ADC0SS0, UDMA_ADC0_ENC);
+  uDMA_PingPong(UDMA_ADC0SS0, &ADC0_SSFIFO0_R, Buf[0],
+                &ADC0_SSFIFO0_R, Buf[1], Count,
+                UDMA_16BIT|UDMA_SRC_FIXED|UDMA_ARB(arb), &Full);
+  ADC0_ACTSS_R |= ADC_ACTSS_ASEN0;
+
+  Timer_Periodic(ADC_TIMER, PLL_BusClock()/rate, 0, 0); // no timer interrupt
+  Timer_TriggerADC(ADC_TIMER, 1);
+  return 1;
+}
+
+// ******** ADC_Wait ************
+// block until the next buffer is full; the buffer stays untouched
+// until the other one has filled, so finish with it by then
+// thread only (without the kernel running it sleeps in WFI)
+// Inputs: where to put the number of samples (may be 0)
+// Outputs: the full buffer
+const uint16_t *ADC_Wait(uint32_t *count){
+  uint32_t sr;
+  Taken = 2;                    // done with the previous one
+  if(OS_Running()){
+    OS_Wait(&Ready);
+  } else{
+    sr = StartCritical();
+    while(Ready <= 0){
+      WaitForInterrupt();       // wakes on the pending interrupt
+      EndCritical(sr);
+      sr = StartCritical();
+    }
+    Ready--;
+    EndCritical(sr);
+  }
+  Taken = Filled;
+  if(count){
+    *count = Count;
+  }
+  return Buf[Taken];
+}
+
+// ******** ADC_Close ************
+// stop sampling, release Timer2 and the ADC0 and port clocks
+// Inputs: none
+// Outputs: none
+void ADC_Close(void){
+  uint32_t port;
+  Timer_Close(ADC_TIMER);
+  ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN0;
+  uDMA_Stop(UDMA_ADC0SS0);
+  NVIC_DIS0_R = 1<<14;
+  Clock_Release(CLOCK_ADC, 0);
+  for(port = 0; port < 6; port++){
+    if(Ports&(1u<<port)){
+      Clock_Release(CLOCK_GPIO, port);
+    }
+  }
+  Ports = 0;
+}
@@ -0,0 +1,49 @@
+// ADC.h
+// Runs on TM4C123
+// Timer-paced sampling on ADC0 sample sequencer 0.  Timer2A starts the
+// sequence at a fixed rate, the sequence converts up to 8 inputs, and
+// the uDMA moves the results into two buffers in turn (ping-pong), so
+// the CPU takes one interrupt per full buffer and the thread in
+// ADC_Wait wakes once per buffer, never per sample.
+// Samples are interleaved in buffer order: input 0, 1, ..., n-1, 0, ...
+
+#ifndef __ADC_H__
+#define __ADC_H__
+
+#include <stdint.h>
+
+#define ADC_BUFSIZE  256        // samples per buffer, at most
+#define ADC_PRI      3          // buffer-full interrupt priority (IRQ 14)
+
+// ******** ADC_Open ************
+// set up the input pins, the sequencer, the uDMA and Timer2A, and
+// start sampling; ADC_Wait hands out the buffers
+// each conversion takes 1 us times the oversampling, so inputs *
+// oversample * rate must stay under 1000000
+// Inputs: analog input numbers (0 to 11 for AIN0-AIN11), how many (1,
+//         2, 4 or 8), sequences per second, hardware averaging over 1,
+//         2, 4, 8, 16, 32 or 64 conversions
+// Outputs: 1 if started, 0 on a bad argument or Timer2 taken
+int ADC_Open(const uint8_t *inputs, uint32_t n, uint32_t rate,
+             uint32_t oversample);
+
+// ******** ADC_Wait ************
+// block until the next buffer is full; the buffer stays untouched
+// until the other one has filled, so finish with it by then
+// thread only (without the kernel running it sleeps in WFI)
+// Inputs: where to put the number of samples (may be 0)
+// Outputs: the full buffer
+const uint16_t *ADC_Wait(uint32_t *count);
+
+// ******** ADC_Close ************
+// stop sampling, release Timer2 and the ADC0 and port clocks
+// Inputs: none
+// Outputs: none
+void ADC_Close(void);
+
+// buffers filled, buffers refilled before the thread was done with
+// them (or had even taken them), and conversions lost because the
+// sequencer FIFO overflowed
+extern volatile uint32_t ADC_Buffers, ADC_Overruns, ADC_FifoOverflows;
+
+#endif
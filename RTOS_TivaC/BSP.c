@@ -0,0 +1,425 @@
+// BSP.c
+// Runs on TM4C123 with the EduBase-V2 trainer
+// Board support layer for the LaunchPad, see BSP.h.
+// The QEMU version of these functions is in BSP_QEMU.c.
+
+#include <stdint.h>
+#include "BSP.h"
+#include "Clock.h"
+#include "PLL.h"
+#include "SevenSeg.h"
+#include "Encoder.h"
+#include "Motor.h"
+#include "Timer.h"
+#include "Timer0A.h"
+#include "tm4c123gh6pm.h"
+
+void DisableInterrupts(void); // Disable interrupts
+void WaitForInterrupt(void);  // low power mode
+
+#ifndef HWREG
+#define HWREG(addr) (*((volatile uint32_t *)(addr)))
+#endif
+
+// Data Watchpoint and Trace unit, not in tm4c123gh6pm.h
+#define DWT_CTRL_R              (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R            (*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA      0x00000001  // enable CYCCNT
+#define NVIC_DBG_INT_TRCENA     0x01000000  // enable DWT and ITM
+
+#define BUSCLOCK    Bus8MHz  // PLL divider; drivers read PLL_BusClock
+
+// UART0 on PA1-0 is the virtual COM port of the LaunchPad debugger
+// divisor bus/(16*115200) in 1/64ths, rounded: 4.3403 (4 and 22) at 8 MHz
+#define BAUD        115200
+
+static uint32_t Slept;       // bus cycles asleep, the DWT stopped
+
+// deep sleep clock PIOSC/DEEPDIV, 1 MHz; DEEPWAKE_US for the wake-up
+// the core doesn't see (the PLL powers up while it is held)
+#define DEEPDIV     16
+#define DEEPWAKE_US 100
+static uint32_t DeepLatency; // worst entry+exit seen, bus cycles
+
+// drivers that can stop their peripherals for a deep sleep, see
+// BSP_DeepClient, and what they have stopped for this one, by kind
+#define DEEPCLIENTS 6
+struct client{
+  uint32_t kind;             // Clock.h kind
+  uint32_t bits;             // its peripherals (CLOCK_DMA: channels)
+  int (*park)(int sleep);
+  uint8_t parked;            // park(1) said yes for this sleep
+};
+static struct client Clients[DEEPCLIENTS];
+static uint32_t NumClients;
+static uint32_t Parked[CLOCK_KINDS];
+#define AWAKE(kind) (Clock_On(kind)&~Parked[(kind)/4]) // on, not parked
+
+static void Retime(uint32_t from, uint32_t to);
+
+// UART0 baud divisors for the current bus clock; UART0 disabled
+static void SetBaud(void){
+  uint32_t div = (8*PLL_BusClock()/BAUD + 1)/2; // 64*bus/(16*BAUD), rounded
+  UART0_IBRD_R = div>>6;                // integer part
+  UART0_FBRD_R = div&0x3F;              // fractional part
+}
+
+// ******** BSP_Init ************
+// set the bus clock and initialize the board peripherals
+// Inputs: none
+// Outputs: none
+void BSP_Init(void){
+  PLL_Init(BUSCLOCK);        // set processor clock, recorded for the drivers
+  PLL_Register(&Retime);     // console baud rate follows it
+
+  // delay service, scaled to the bus clock just set
+  Timer0A_Init();
+
+  // motor encoder on PC4, timestamped by Wide Timer0A
+  Encoder_Init();
+
+  // motor PWM on PE4-5, fault input PD2, stopped
+  Motor_Init();
+
+  // 7-segment display, scanned by the uDMA off Timer1A over SSI2
+  SevenSeg_Init();
+
+  // console on UART0, PA1-0
+  Clock_Acquire(CLOCK_UART, 0);
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTA);
+  UART0_CTL_R &= ~UART_CTL_UARTEN;      // disable UART during setup
+  SetBaud();
+  UART0_LCRH_R = (UART_LCRH_WLEN_8|UART_LCRH_FEN); // 8 bit, no parity, one stop, FIFOs
+  UART0_CTL_R |= UART_CTL_UARTEN;       // enable UART
+  GPIO_PORTA_AFSEL_R |= 0x03;           // enable alt funct on PA1-0
+  GPIO_PORTA_DEN_R |= 0x03;             // enable digital I/O on PA1-0
+  GPIO_PORTA_PCTL_R = (GPIO_PORTA_PCTL_R&0xFFFFFF00)+0x00000011; // UART
+  GPIO_PORTA_AMSEL_R &= ~0x03;          // disable analog functionality on PA
+
+  // cycle counter for the benchmarks
+  NVIC_DBG_INT_R |= NVIC_DBG_INT_TRCENA;
+  DWT_CYCCNT_R = 0;
+  DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+}
+
+// ******** BSP_OutChar ************
+// send one character to UART0, busy-waits while the TX FIFO is full
+// Inputs: character to send
+// Outputs: none
+void BSP_OutChar(char c){
+  while((UART0_FR_R&UART_FR_TXFF) != 0){};
+  UART0_DR_R = c;
+}
+
+// ******** BSP_OutString ************
+// send a NULL-terminated string to UART0
+// Inputs: pointer to the string
+// Outputs: none
+void BSP_OutString(const char *pt){
+  while(*pt){
+    BSP_OutChar(*pt);
+    pt++;
+  }
+}
+
+// ******** BSP_Cycles ************
+// read the DWT cycle counter, one count per bus clock
+// Inputs: none
+// Outputs: 32-bit count, wraps around
+uint32_t BSP_Cycles(void){
+  return DWT_CYCCNT_R + Slept;
+}
+
+// base addresses, by the bit of the peripheral in its RCGC/SCGC register
+static const uint32_t GPIOBase[6] = {  // APB
+  0x40004000, 0x40005000, 0x40006000, 0x40007000, 0x40024000, 0x40025000
+};
+static const uint32_t TimerBase[6] = {
+  0x40030000, 0x40031000, 0x40032000, 0x40033000, 0x40034000, 0x40035000
+};
+static const uint32_t WTimerBase[6] = {
+  0x40036000, 0x40037000, 0x4004C000, 0x4004D000, 0x4004E000, 0x4004F000
+};
+static const uint32_t SSIBase[4] = {
+  0x40008000, 0x40009000, 0x4000A000, 0x4000B000
+};
+static const uint32_t UARTBase[8] = {
+  0x4000C000, 0x4000D000, 0x4000E000, 0x4000F000,
+  0x40010000, 0x40011000, 0x40012000, 0x40013000
+};
+static const uint32_t ADCBase[2] = {0x40038000, 0x40039000};
+static const uint32_t PWMBase[2] = {0x40028000, 0x40029000};
+static const uint32_t QEIBase[2] = {0x4002C000, 0x4002D000};
+
+// the ones of n peripherals with their clock on (bits of on) whose
+// register at offset has a bit of mask set; a gated one isn't read,
+// that would fault
+static uint32_t Busy(const uint32_t *base, uint32_t n, uint32_t on,
+                     uint32_t offset, uint32_t mask){
+  uint32_t i, busy = 0;
+  for(i = 0; i < n; i++){
+    if((on&(1u<<i)) && (HWREG(base[i] + offset)&mask)){
+      busy |= 1u<<i;
+    }
+  }
+  return busy;
+}
+
+// sleep (SCGC) and deep-sleep (DCGC) clock gating, one register per
+// kind of peripheral at the offsets of Clock.h
+#define SCGC       0x400FE700
+#define DCGC       0x400FE800
+
+// sleep or deep-sleep clocks (block SCGC or DCGC) from what is running
+// now: a timer counting, a serial port, converter, PWM or QEI switched
+// on, a port with pin interrupts or pins lent to a peripheral, the uDMA
+// enabled with a channel enabled; a port of plain inputs and outputs
+// holds its pins without a clock; kinds not listed here keep their
+// run-mode clocks; peripherals parked for a deep sleep stand still
+static void Gate(uint32_t block){
+  uint32_t k, gpio = Clock_On(CLOCK_GPIO);
+  HWREG(block+CLOCK_GPIO) = Busy(GPIOBase, 6, gpio, 0x410, 0xFF)    // IM
+                          | Busy(GPIOBase, 6, gpio, 0x420, 0xFF);   // AFSEL
+  HWREG(block+CLOCK_TIMER) =
+    Busy(TimerBase, 6, Clock_On(CLOCK_TIMER), 0x00C, 0x101);        // CTL
+  HWREG(block+CLOCK_WTIMER) =
+    Busy(WTimerBase, 6, Clock_On(CLOCK_WTIMER), 0x00C, 0x101);
+  HWREG(block+CLOCK_SSI) =
+    Busy(SSIBase, 4, Clock_On(CLOCK_SSI), 0x004, SSI_CR1_SSE);      // CR1
+  HWREG(block+CLOCK_UART) =
+    Busy(UARTBase, 8, Clock_On(CLOCK_UART), 0x030, UART_CTL_UARTEN);
+  HWREG(block+CLOCK_ADC) =
+    Busy(ADCBase, 2, Clock_On(CLOCK_ADC), 0x000, 0x0F);             // ACTSS
+  HWREG(block+CLOCK_PWM) =
+    Busy(PWMBase, 2, Clock_On(CLOCK_PWM), 0x008, 0xFF);             // ENABLE
+  HWREG(block+CLOCK_QEI) =
+    Busy(QEIBase, 2, Clock_On(CLOCK_QEI), 0x000, 0x01);             // CTL
+  HWREG(block+CLOCK_DMA) = ((Clock_On(CLOCK_DMA)&0x01) &&
+                            (UDMA_STAT_R&UDMA_STAT_MASTEN) &&
+                            (UDMA_ENASET_R&~Parked[CLOCK_DMA/4])) ? 0x01 : 0;
+  HWREG(block+CLOCK_WD) = Clock_On(CLOCK_WD);
+  HWREG(block+CLOCK_HIB) = Clock_On(CLOCK_HIB);
+  HWREG(block+CLOCK_I2C) = Clock_On(CLOCK_I2C);
+  HWREG(block+CLOCK_USB) = Clock_On(CLOCK_USB);
+  HWREG(block+CLOCK_CAN) = Clock_On(CLOCK_CAN);
+  HWREG(block+CLOCK_ACMP) = Clock_On(CLOCK_ACMP);
+  HWREG(block+CLOCK_EEPROM) = Clock_On(CLOCK_EEPROM);
+  for(k = 0; k < CLOCK_KINDS; k++){
+    if(Parked[k] && (4*k != CLOCK_DMA)){
+      HWREG(block+4*k) &= ~Parked[k];
+    }
+  }
+}
+
+// ******** BSP_Sleep ************
+// WFI with the clocks of idle peripherals gated; interrupts disabled
+// the time is read off the periodic task's Timer5A, which keeps
+// counting asleep and whose interrupt ends the sleep within a period;
+// automatic gating (ACG) is on only here and in BSP_DeepSleep, so WFIs
+// elsewhere (LCD, SSI2, ADC before the kernel runs) sleep with every
+// clock on
+// Inputs: none
+// Outputs: bus cycles slept
+uint32_t BSP_Sleep(void){
+  uint32_t before, after, period, slept;
+  Gate(SCGC);
+  period = TIMER5_TAILR_R + 1;
+  before = Timer_Read(TIMER_5);
+  SYSCTL_RCC_R |= SYSCTL_RCC_ACG;       // sleep clocks from SCGC
+  WaitForInterrupt();
+  SYSCTL_RCC_R &= ~SYSCTL_RCC_ACG;
+  after = Timer_Read(TIMER_5);          // counts down, reloads once at most
+  slept = (before >= after) ? before - after : before + period - after;
+  Slept = Slept + slept;
+  return slept;
+}
+
+// ask each client to park its peripherals for a deep sleep; those
+// that do are left out of Quiet and gated by Gate(DCGC)
+static void Park(void){
+  uint32_t i;
+  for(i = 0; i < NumClients; i++){
+    Clients[i].parked = ((*Clients[i].park)(1) != 0);
+    if(Clients[i].parked){
+      Parked[Clients[i].kind/4] |= Clients[i].bits;
+    }
+  }
+}
+
+// after the deep sleep, or instead of it: the parked ones carry on
+static void Unpark(void){
+  uint32_t i;
+  for(i = 0; i < NumClients; i++){
+    if(Clients[i].parked){
+      Clients[i].parked = 0;
+      Parked[Clients[i].kind/4] &= ~Clients[i].bits;
+      (*Clients[i].park)(0);
+    }
+  }
+}
+
+// 1 if nothing that counts bus cycles runs but the periodic task's
+// Timer5A and what is parked, and no serial port is mid-frame: deep
+// sleep runs every clock off the slow PIOSC/DEEPDIV, which would
+// stretch them
+static int Quiet(void){
+  uint32_t busy;
+  busy = Busy(TimerBase, 6, AWAKE(CLOCK_TIMER)&~0x20, 0x00C, 0x101)
+       | Busy(WTimerBase, 6, AWAKE(CLOCK_WTIMER), 0x00C, 0x101)
+       | Busy(ADCBase, 2, AWAKE(CLOCK_ADC), 0x000, 0x0F)
+       | Busy(PWMBase, 2, AWAKE(CLOCK_PWM), 0x008, 0xFF)
+       | Busy(QEIBase, 2, AWAKE(CLOCK_QEI), 0x000, 0x01)
+       | Busy(SSIBase, 4, Clock_On(CLOCK_SSI), 0x00C, SSI_SR_BSY)     // SR
+       | Busy(UARTBase, 8, Clock_On(CLOCK_UART), 0x018, UART_FR_BUSY);// FR
+  return (busy == 0) && (((Clock_On(CLOCK_DMA)&0x01) == 0) ||
+                         ((UDMA_ENASET_R&~Parked[CLOCK_DMA/4]) == 0));
+}
+
+// ******** BSP_DeepClient ************
+// have a driver's idle peripherals stopped for deep sleeps, see BSP.h
+// Inputs: kind (Clock.h), its peripherals, bit n for number n (the
+//         channels for CLOCK_DMA), function parking and unparking them
+// Outputs: 1 if added, 0 if DEEPCLIENTS are in already
+int BSP_DeepClient(uint32_t kind, uint32_t bits, int (*park)(int sleep)){
+  if(NumClients >= DEEPCLIENTS){
+    return 0;
+  }
+  Clients[NumClients].kind = kind;
+  Clients[NumClients].bits = bits;
+  Clients[NumClients].park = park;
+  Clients[NumClients].parked = 0;
+  NumClients++;
+  return 1;
+}
+
+// ******** BSP_DeepLatency ************
+// worst entry plus exit time of BSP_DeepSleep measured so far
+// Inputs: none
+// Outputs: time in us, DEEPWAKE_US before the first deep sleep
+uint32_t BSP_DeepLatency(void){
+  return (uint32_t)((uint64_t)DeepLatency*1000000/PLL_BusClock()) + DEEPWAKE_US;
+}
+
+// ******** BSP_DeepSleep ************
+// deep sleep on PIOSC/DEEPDIV until shortly before the ticks-th
+// timeout of Timer5A, which times the sleep and wakes the core; the
+// ticks skipped are counted, not run, and Timer5A is put back in phase
+// the entry (up to the WFI, parking the clients) and exit (until the
+// PLL has locked again and they are unparked) are timed on the DWT;
+// the hardware's own wake-up, before the core runs, can't be seen from
+// here and is taken to be DEEPWAKE_US
+// Inputs: timeouts to the next deadline (2 or more), where to put the
+//         number of timeouts skipped
+// Outputs: bus cycles in deep sleep, 0 if it didn't (Timer5A not
+//          running or its timeout pending, or something busy that no
+//          client parked)
+uint32_t BSP_DeepSleep(uint32_t ticks, uint32_t *skipped){
+  uint32_t t0, t1, t2, period, phase, count, left, entry, leave, bus;
+  uint64_t span, wake, slept, total;
+  *skipped = 0;
+  if((ticks < 2) || ((TIMER5_CTL_R&TIMER_CTL_TAEN) == 0) ||
+     (TIMER5_RIS_R&TIMER_ICR_TATOCINT)){
+    return 0;
+  }
+  t0 = DWT_CYCCNT_R;
+  bus = PLL_BusClock();
+  period = TIMER5_TAILR_R + 1;
+  phase = TIMER5_TAV_R;                 // to the next timeout
+  // to the ticks-th timeout, less the time it takes to wake up
+  span = phase + (uint64_t)(ticks - 1)*period;
+  wake = (uint64_t)DEEPWAKE_US*bus/1000000 + DeepLatency;
+  if(span <= wake){
+    return 0;
+  }
+  span = (span - wake)*(16000000/DEEPDIV)/bus; // in deep-sleep clocks
+  count = (span > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)span;
+  if(count < 2){
+    return 0;
+  }
+  Park();
+  if(Quiet() == 0){
+    Unpark();
+    return 0;
+  }
+  Gate(DCGC);
+  SYSCTL_DSLPCLKCFG_R = ((DEEPDIV - 1)<<SYSCTL_DSLPCLKCFG_D_S)|
+                        SYSCTL_DSLPCLKCFG_O_IO;
+  Timer_Start(TIMER_5, count);
+  SYSCTL_RCC_R |= SYSCTL_RCC_ACG;
+  NVIC_SYS_CTRL_R |= NVIC_SYS_CTRL_SLEEPDEEP;
+  t1 = DWT_CYCCNT_R;
+  WaitForInterrupt();
+  left = TIMER5_TAV_R;
+  if(TIMER5_RIS_R&TIMER_ICR_TATOCINT){
+    left = 0;                           // timed out and reloaded
+  }
+  NVIC_SYS_CTRL_R &= ~NVIC_SYS_CTRL_SLEEPDEEP;
+  SYSCTL_RCC_R &= ~SYSCTL_RCC_ACG;
+  t2 = DWT_CYCCNT_R;
+  PLL_Resume();
+  Unpark();
+  entry = t1 - t0;
+  leave = DWT_CYCCNT_R - t2;
+  if(entry + leave > DeepLatency){
+    DeepLatency = entry + leave;
+  }
+  // asleep, in bus cycles, then everything since the phase was read
+  slept = (uint64_t)(count - left)*bus/(16000000/DEEPDIV) +
+          (uint64_t)DEEPWAKE_US*bus/1000000;
+  total = slept + (DWT_CYCCNT_R - t0);
+  if(total < phase){
+    phase = phase - (uint32_t)total;    // same tick still to come
+  } else{
+    *skipped = 1 + (uint32_t)((total - phase)/period);
+    phase = period - (uint32_t)((total - phase)%period);
+  }
+  Timer_Start(TIMER_5, period);         // forgets the wake-up timeout
+  TIMER5_TAV_R = phase;
+  Slept = Slept + (uint32_t)slept;
+  return (uint32_t)slept;
+}
+
+static void (*PeriodicTask)(void); // user function run by Timer5A
+
+static void RunPeriodicTask(uint32_t timer, uint32_t status){
+  (*PeriodicTask)();
+}
+
+// ******** BSP_PeriodicTask_Init ************
+// run a function periodically in the Timer5A interrupt
+// Inputs: task to run, frequency in Hz, NVIC priority 0 (highest) to 6
+// Outputs: none
+void BSP_PeriodicTask_Init(void(*task)(void), uint32_t freq, uint32_t priority){
+  PeriodicTask = task;
+  if(Timer_Open(TIMER_5, "periodic task")){
+    Timer_Periodic(TIMER_5, PLL_BusClock()/freq, priority, &RunPeriodicTask);
+  }
+}
+
+// new bus clock: same baud rate (the Timer driver keeps the periodic
+// task's rate); the line is let go idle first, so a character isn't
+// cut in two, which can take a FIFO of them, 1.4 ms, interrupts disabled
+static void Retime(uint32_t from, uint32_t to){
+  while(UART0_FR_R&UART_FR_BUSY){};
+  UART0_CTL_R &= ~UART_CTL_UARTEN;
+  SetBaud();
+  UART0_LCRH_R = UART0_LCRH_R;          // latches the new divisors
+  UART0_CTL_R |= UART_CTL_UARTEN;
+}
+
+// ******** BSP_ClockClient ************
+// have a function called whenever PLL_SetFrequency changes the clock
+// Inputs: function getting the old and new bus clock in Hz
+// Outputs: none
+void BSP_ClockClient(void (*retime)(uint32_t from, uint32_t to)){
+  PLL_Register(retime);
+}
+
+// ******** BSP_Exit ************
+// nothing to return to on the LaunchPad; stop here for the debugger
+// Inputs: exit code (visible in R0 from the debugger)
+// Outputs: none (does not return)
+void BSP_Exit(int32_t code){
+  DisableInterrupts();
+  while(1){};
+}
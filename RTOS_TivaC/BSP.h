@@ -0,0 +1,117 @@
+// BSP.h
+// Runs on TM4C123 (EduBase-V2) or the QEMU mps2-an386 machine
+// Board support layer.  The kernel and the benchmark code reach the
+// board only through these functions, so the TM4C123/EduBase drivers
+// in BSP.c can be swapped for the QEMU versions in BSP_QEMU.c without
+// touching os.c or OSasm.asm.
+
+#ifndef __BSP_H__
+#define __BSP_H__
+
+#include <stdint.h>
+
+// ******** BSP_Init ************
+// set the bus clock and initialize the board peripherals
+// (PLL, timers, SSI2, 7-segment display and console on the LaunchPad;
+// console and cycle counter only on QEMU)
+// called from OS_Init with interrupts disabled
+// Inputs: none
+// Outputs: none
+void BSP_Init(void);
+
+// ******** BSP_OutChar ************
+// send one character to the console
+// (UART0 virtual COM port on the LaunchPad, CMSDK UART0 on QEMU)
+// Inputs: character to send
+// Outputs: none
+void BSP_OutChar(char c);
+
+// ******** BSP_OutString ************
+// send a NULL-terminated string to the console
+// Inputs: pointer to the string
+// Outputs: none
+void BSP_OutString(const char *pt);
+
+// ******** BSP_Cycles ************
+// read the free-running cycle counter
+// LaunchPad: DWT_CYCCNT, one count per bus clock, plus the time
+// BSP_Sleep slept (the DWT stops with the core)
+// QEMU: CMSDK timer scaled to instructions (run with -icount shift=0)
+// Inputs: none
+// Outputs: 32-bit count, wraps around
+uint32_t BSP_Cycles(void);
+
+// ******** BSP_Sleep ************
+// sleep until an interrupt is pending; call with interrupts disabled,
+// the interrupt then runs once they are enabled again
+// LaunchPad: WFI with the clocks of idle peripherals gated (SCGC),
+// timed on the BSP_PeriodicTask_Init timer, which must be running
+// QEMU: WFI
+// Inputs: none
+// Outputs: bus cycles slept
+uint32_t BSP_Sleep(void);
+
+// ******** BSP_DeepSleep ************
+// deep sleep until shortly before the ticks-th timeout of the periodic
+// task, skipping the timeouts before it (they are counted, not run);
+// call with interrupts disabled, any interrupt ends it early
+// LaunchPad: only while nothing but the periodic task's timer counts
+// bus cycles, once the BSP_DeepClient drivers have parked what they
+// can; clocks from PIOSC with idle peripherals gated (DCGC); the PLL
+// has locked again and the drivers are unparked before it returns
+// QEMU: never
+// Inputs: timeouts to the next deadline, where to put the number of
+//         timeouts skipped
+// Outputs: bus cycles in deep sleep, 0 if it didn't sleep
+uint32_t BSP_DeepSleep(uint32_t ticks, uint32_t *skipped);
+
+// ******** BSP_DeepClient ************
+// let BSP_DeepSleep stop a driver's peripherals while the driver is
+// idle, rather than refuse to sleep because they run: before each deep
+// sleep park(1) is called, and if the driver can do without them until
+// it wakes, it makes them safe to stop (outputs off) and returns 1;
+// they then don't count as busy and their deep-sleep clocks are gated,
+// so they stand still, interrupts and uDMA requests included, and
+// carry on where they were.  After the sleep, or if it doesn't happen,
+// park(0) is called for each park(1) that returned 1.  Both run with
+// interrupts disabled.  A driver with peripherals of several kinds adds
+// one client per kind, so its park may be called more than once
+// LaunchPad: called by the drivers' Init functions
+// QEMU: never calls park, there is no deep sleep
+// Inputs: kind (Clock.h), its peripherals, bit n for number n (the
+//         channels for CLOCK_DMA), the driver's park function
+// Outputs: 1 if added, 0 if the table is full
+int BSP_DeepClient(uint32_t kind, uint32_t bits, int (*park)(int sleep));
+
+// ******** BSP_DeepLatency ************
+// worst time BSP_DeepSleep has taken to go to sleep and wake up again,
+// so the caller can tell whether a deep sleep would pay off
+// Inputs: none
+// Outputs: time in us (0 on QEMU)
+uint32_t BSP_DeepLatency(void);
+
+// ******** BSP_PeriodicTask_Init ************
+// run a function periodically in a dedicated timer interrupt
+// used by OS_Launch for the kernel tick
+// LaunchPad: Timer5A (IRQ 92); QEMU: CMSDK timer 1 (IRQ 9)
+// Inputs: task to run, frequency in Hz, NVIC priority 0 (highest) to 6
+// Outputs: none
+void BSP_PeriodicTask_Init(void(*task)(void), uint32_t freq, uint32_t priority);
+
+// ******** BSP_ClockClient ************
+// have a function called whenever the bus clock changes, with
+// interrupts disabled (PLL_SetFrequency on the LaunchPad; the QEMU
+// clock never changes, so there it is never called)
+// Inputs: function getting the old and new bus clock in Hz
+// Outputs: none
+void BSP_ClockClient(void (*retime)(uint32_t from, uint32_t to));
+
+// ******** BSP_Exit ************
+// end an automated run
+// QEMU: semihosting exit, so the emulator returns to the shell
+// LaunchPad: disable interrupts and spin for the debugger
+// Inputs: 0 for success, nonzero for failure
+// Outputs: none (does not return)
+void BSP_Exit(int32_t code);
+
+#endif
@@ -0,0 +1,175 @@
+// BSP_QEMU.c
+// Runs on the QEMU mps2-an386 machine (Cortex-M4, ARM MPS2 FPGA image)
+// Board support layer for benchmark runs without a LaunchPad, see BSP.h.
+// Only compiled when BOARD_QEMU is defined (qemu/Makefile); the CCS
+// project for the LaunchPad uses BSP.c instead.
+// SysTick, NVIC and the SCB are part of the Cortex-M4 core, so OSasm.asm
+// and os.c run unmodified; only the board peripherals differ.
+// Run with -icount shift=0 so one instruction advances the virtual
+// clock by 1 ns, and the 25 MHz CMSDK timer counts every 40 instructions.
+
+#ifdef BOARD_QEMU
+
+#include <stdint.h>
+#include "BSP.h"
+
+// CMSDK APB UART0, connected to the QEMU console by -nographic
+#define UART0_DATA_R    (*((volatile uint32_t *)0x40004000))
+#define UART0_STATE_R   (*((volatile uint32_t *)0x40004004))
+#define UART0_CTRL_R    (*((volatile uint32_t *)0x40004008))
+#define UART0_BAUDDIV_R (*((volatile uint32_t *)0x40004010))
+#define UART_STATE_TXFULL 0x00000001  // TX buffer full
+#define UART_CTRL_TXEN    0x00000001  // TX enable
+
+// CMSDK APB timer 0, free-running down counter at the 25 MHz system clock
+#define TIMER0_CTRL_R   (*((volatile uint32_t *)0x40000000))
+#define TIMER0_VALUE_R  (*((volatile uint32_t *)0x40000004))
+#define TIMER0_RELOAD_R (*((volatile uint32_t *)0x40000008))
+#define TIMER_CTRL_EN     0x00000001  // enable
+#define TIMER_CTRL_IRQEN  0x00000008  // interrupt enable
+
+// CMSDK APB timer 1, periodic interrupt for BSP_PeriodicTask_Init
+#define TIMER1_CTRL_R   (*((volatile uint32_t *)0x40001000))
+#define TIMER1_VALUE_R  (*((volatile uint32_t *)0x40001004))
+#define TIMER1_RELOAD_R (*((volatile uint32_t *)0x40001008))
+#define TIMER1_INTCLEAR_R (*((volatile uint32_t *)0x4000100C))
+
+// Cortex-M4 NVIC, same addresses as in tm4c123gh6pm.h
+#define NVIC_EN0_R      (*((volatile uint32_t *)0xE000E100))
+#define NVIC_PRI2_R     (*((volatile uint32_t *)0xE000E408))
+
+#define SYSCLK          25000000     // mps2-an386 system clock
+#define INSN_PER_TICK   40           // 1e9/SYSCLK ns per tick, 1 ns per insn
+
+// ******** BSP_Init ************
+// console and cycle counter; the emulated clock tree is fixed
+// Inputs: none
+// Outputs: none
+void BSP_Init(void){
+  UART0_BAUDDIV_R = SYSCLK/115200; // QEMU ignores the rate, but needs >= 16
+  UART0_CTRL_R = UART_CTRL_TXEN;
+
+  TIMER0_CTRL_R = 0;
+  TIMER0_RELOAD_R = 0xFFFFFFFF;
+  TIMER0_VALUE_R = 0xFFFFFFFF;
+  TIMER0_CTRL_R = TIMER_CTRL_EN;
+}
+
+// ******** BSP_OutChar ************
+// send one character to the CMSDK UART0
+// Inputs: character to send
+// Outputs: none
+void BSP_OutChar(char c){
+  while(UART0_STATE_R&UART_STATE_TXFULL){};
+  UART0_DATA_R = c;
+}
+
+// ******** BSP_OutString ************
+// send a NULL-terminated string to the CMSDK UART0
+// Inputs: pointer to the string
+// Outputs: none
+void BSP_OutString(const char *pt){
+  while(*pt){
+    BSP_OutChar(*pt);
+    pt++;
+  }
+}
+
+// ******** BSP_Cycles ************
+// elapsed instructions, derived from the CMSDK timer
+// resolution is INSN_PER_TICK, so time many iterations and divide
+// Inputs: none
+// Outputs: 32-bit count, wraps around
+uint32_t BSP_Cycles(void){
+  return (0xFFFFFFFF - TIMER0_VALUE_R)*INSN_PER_TICK;
+}
+
+void WaitForInterrupt(void);  // low power mode
+
+// ******** BSP_Sleep ************
+// WFI; with -icount the virtual clock, and so BSP_Cycles, runs on
+// while the emulated core is halted
+// Inputs: none
+// Outputs: instructions' worth of time slept
+uint32_t BSP_Sleep(void){
+  uint32_t start = BSP_Cycles();
+  WaitForInterrupt();
+  return BSP_Cycles() - start;
+}
+
+// ******** BSP_DeepSleep ************
+// the MPS2 has no deep-sleep clock tree to model, plain BSP_Sleep only
+// Inputs: timeouts to the next deadline, where to put 0 skipped
+// Outputs: 0, didn't sleep
+uint32_t BSP_DeepSleep(uint32_t ticks, uint32_t *skipped){
+  *skipped = 0;
+  return 0;
+}
+
+// ******** BSP_DeepClient ************
+// no deep sleep here, nothing to park
+// Inputs: kind, peripherals, park function
+// Outputs: 1
+int BSP_DeepClient(uint32_t kind, uint32_t bits, int (*park)(int sleep)){
+  return 1;
+}
+
+// ******** BSP_DeepLatency ************
+// Inputs: none
+// Outputs: 0, see BSP_DeepSleep
+uint32_t BSP_DeepLatency(void){
+  return 0;
+}
+
+static void (*PeriodicTask)(void); // user function run by the timer 1 interrupt
+
+// ******** BSP_PeriodicTask_Init ************
+// run a function periodically in the CMSDK timer 1 interrupt (IRQ 9)
+// Inputs: task to run, frequency in Hz, NVIC priority 0 (highest) to 6
+// Outputs: none
+void BSP_PeriodicTask_Init(void(*task)(void), uint32_t freq, uint32_t priority){
+  PeriodicTask = task;
+  TIMER1_CTRL_R = 0;                // disable during setup
+  TIMER1_RELOAD_R = SYSCLK/freq - 1;
+  TIMER1_VALUE_R = SYSCLK/freq - 1;
+  TIMER1_INTCLEAR_R = 1;
+  NVIC_PRI2_R = (NVIC_PRI2_R&0xFFFF00FF)|((priority&0x07)<<13); // IRQ 9
+  NVIC_EN0_R = 1<<9;
+  TIMER1_CTRL_R = TIMER_CTRL_EN|TIMER_CTRL_IRQEN;
+}
+
+// ******** BSP_ClockClient ************
+// the emulated clock tree is fixed, nothing to call
+// Inputs: function getting the old and new bus clock in Hz
+// Outputs: none
+void BSP_ClockClient(void (*retime)(uint32_t from, uint32_t to)){
+}
+
+// IRQ 9 is CMSDK timer 1 on the MPS2; the shared startup file
+// names that vector after the TM4C123 PWM0 fault interrupt
+void PWM0Fault_Handler(void){
+  TIMER1_INTCLEAR_R = 1;            // acknowledge
+  (*PeriodicTask)();
+}
+
+// ******** BSP_Exit ************
+// semihosting SYS_EXIT (needs -semihosting-config enable=on)
+// QEMU exits with status 0 for ADP_Stopped_ApplicationExit, 1 otherwise
+// Inputs: 0 for success, nonzero for failure
+// Outputs: none (does not return)
+void BSP_Exit(int32_t code){
+  if(code == 0){
+    __asm("    MOV    R0, #0x18         ; SYS_EXIT\n"
+          "    MOVW   R1, #0x0026       ; ADP_Stopped_ApplicationExit\n"
+          "    MOVT   R1, #0x0002\n"
+          "    BKPT   #0xAB\n");
+  } else{
+    __asm("    MOV    R0, #0x18         ; SYS_EXIT\n"
+          "    MOVW   R1, #0x0023       ; ADP_Stopped_RunTimeErrorUnknown\n"
+          "    MOVT   R1, #0x0002\n"
+          "    BKPT   #0xAB\n");
+  }
+  while(1){};
+}
+
+#endif
@@ -0,0 +1,77 @@
+// Clock.c
+// Runs on TM4C123
+// Peripheral clock manager, see Clock.h.
+// One count per peripheral; the RCGC bit is set on the count's way up
+// from 0 and cleared on its way back, with interrupts disabled, so a
+// driver acquiring in a thread and another releasing in an interrupt
+// handler can't leave the clock off under a user.  The wait for PR is
+// outside, a peripheral turned on by another user may still be coming
+// up.  Clocks turned on by code that doesn't use the manager aren't
+// counted, and are never turned off by it.
+
+#include <stdint.h>
+#include "Clock.h"
+#include "tm4c123gh6pm.h"
+
+#ifndef HWREG
+#define HWREG(addr) (*((volatile uint32_t *)(addr)))
+#endif
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+
+#define RCGC  0x400FE600         // run-mode clock gating, RCGCWD first
+#define PR    0x400FEA00         // peripheral ready, PRWD first
+
+static uint8_t Users[CLOCK_KINDS][8];
+
+// ******** Clock_Acquire ************
+// add a user of a peripheral, turning its clock on for the first, and
+// wait until it is ready (PR register) to be touched
+// Inputs: kind, number (0 to 7)
+// Outputs: 1 if this turned the clock on, so the caller is the first
+//          user and sets the peripheral up; 0 if it was on already
+int Clock_Acquire(uint32_t kind, uint32_t n){
+  uint32_t bit = 1u<<n, sr;
+  int first;
+  sr = StartCritical();
+  first = (Users[kind/4][n] == 0);
+  if(first){
+    HWREG(RCGC+kind) |= bit;
+  }
+  Users[kind/4][n]++;
+  EndCritical(sr);
+  while((HWREG(PR+kind)&bit) == 0){};
+  return first;
+}
+
+// ******** Clock_Release ************
+// drop a user of a peripheral; the last one gates its clock
+// Inputs: kind, number (0 to 7)
+// Outputs: none
+void Clock_Release(uint32_t kind, uint32_t n){
+  uint32_t sr;
+  sr = StartCritical();
+  if(Users[kind/4][n]){
+    Users[kind/4][n]--;
+    if(Users[kind/4][n] == 0){
+      HWREG(RCGC+kind) &= ~(1u<<n);
+    }
+  }
+  EndCritical(sr);
+}
+
+// ******** Clock_Users ************
+// Inputs: kind, number (0 to 7)
+// Outputs: number of users of the peripheral
+uint32_t Clock_Users(uint32_t kind, uint32_t n){
+  return Users[kind/4][n];
+}
+
+// ******** Clock_On ************
+// which clocks of a kind are on
+// Inputs: kind
+// Outputs: the RCGC register, bit n for peripheral n
+uint32_t Clock_On(uint32_t kind){
+  return HWREG(RCGC+kind);
+}
@@ -0,0 +1,72 @@
+// Clock.h
+// Runs on TM4C123
+// Peripheral clock manager.  Every driver acquires the clocks of the
+// peripherals it uses and releases them when it is done with them; a
+// peripheral's run-mode clock (RCGC) is on while it has at least one
+// user and is gated again when the last one releases it, so idle
+// peripherals draw no power and shared ones (port C serves the LCD,
+// the 7-segment display and the encoder) are set up once.
+// A peripheral is named by its kind, the offset of its register in the
+// RCGC/SCGC/DCGC/PR blocks, and its number within the kind, which is
+// its bit in those registers: Clock_Acquire(CLOCK_GPIO, CLOCK_PORTC).
+// Registers of a gated peripheral keep their values, but touching one
+// faults, so a driver only releases a clock it no longer reads.
+
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include <stdint.h>
+
+// kinds
+#define CLOCK_WD      0x00
+#define CLOCK_TIMER   0x04
+#define CLOCK_GPIO    0x08
+#define CLOCK_DMA     0x0C
+#define CLOCK_HIB     0x14
+#define CLOCK_UART    0x18
+#define CLOCK_SSI     0x1C
+#define CLOCK_I2C     0x20
+#define CLOCK_USB     0x28
+#define CLOCK_CAN     0x34
+#define CLOCK_ADC     0x38
+#define CLOCK_ACMP    0x3C
+#define CLOCK_PWM     0x40
+#define CLOCK_QEI     0x44
+#define CLOCK_EEPROM  0x58
+#define CLOCK_WTIMER  0x5C
+#define CLOCK_KINDS   (CLOCK_WTIMER/4 + 1)
+
+// GPIO port numbers (APB)
+#define CLOCK_PORTA   0
+#define CLOCK_PORTB   1
+#define CLOCK_PORTC   2
+#define CLOCK_PORTD   3
+#define CLOCK_PORTE   4
+#define CLOCK_PORTF   5
+
+// ******** Clock_Acquire ************
+// add a user of a peripheral, turning its clock on for the first, and
+// wait until it is ready (PR register) to be touched
+// Inputs: kind, number (0 to 7)
+// Outputs: 1 if this turned the clock on, so the caller is the first
+//          user and sets the peripheral up; 0 if it was on already
+int Clock_Acquire(uint32_t kind, uint32_t n);
+
+// ******** Clock_Release ************
+// drop a user of a peripheral; the last one gates its clock
+// Inputs: kind, number (0 to 7)
+// Outputs: none
+void Clock_Release(uint32_t kind, uint32_t n);
+
+// ******** Clock_Users ************
+// Inputs: kind, number (0 to 7)
+// Outputs: number of users of the peripheral
+uint32_t Clock_Users(uint32_t kind, uint32_t n);
+
+// ******** Clock_On ************
+// which clocks of a kind are on
+// Inputs: kind
+// Outputs: the RCGC register, bit n for peripheral n
+uint32_t Clock_On(uint32_t kind);
+
+#endif
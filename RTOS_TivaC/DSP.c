@@ -0,0 +1,293 @@
+// DSP.c
+// Runs on TM4C123, or any C compiler
+// Fixed-point filters, see DSP.h.
+// Two Q15 samples travel as one 32-bit word (first sample in the low
+// half), so one load and one SMLALD do two taps.  The FIR keeps its
+// coefficients reversed, so coefficients and samples are both walked
+// upward in pairs, and pads the length to a multiple of 4 with leading
+// 0 taps, so the inner loop is two SMLALDs with no odd tap left over.
+// Sample pairs start on any halfword; the M4 loads those in one LDR
+// (unaligned access is on by default), and the packed struct tells the
+// compiler not to merge them into LDRD/LDM, which would fault.
+// Accumulators are 64 bits, so even 32 full-scale taps can't wrap; the
+// result saturates once, when it is scaled back to Q15.
+
+#include <stdint.h>
+#include "DSP.h"
+
+#if defined(__TI_ARM__) && defined(__TI_ARM_V7M4__)
+// TI compiler intrinsics, one instruction each
+#define SMLALD(acc, x, y)  _smlald((acc), (x), (y))
+#define QADD16(x, y)       _qadd16((x), (y))
+#elif defined(__ARM_FEATURE_DSP)
+// gcc or clang for a Cortex-M4
+#include <arm_acle.h>
+#define SMLALD(acc, x, y)  __smlald((x), (y), (acc))
+#define QADD16(x, y)       ((int32_t)__qadd16((x), (y)))
+#endif
+
+// Q15 limits
+#define Q15MAX  32767
+#define Q15MIN  -32768
+
+static int16_t Sat16(int32_t v){
+  if(v > Q15MAX) return Q15MAX;
+  if(v < Q15MIN) return Q15MIN;
+  return (int16_t)v;
+}
+
+// low and high halves of a sample pair
+#define LO(w) ((int16_t)(w))
+#define HI(w) ((int16_t)((uint32_t)(w)>>16))
+// pair with a in the low half, b in the high half
+#define PACK(a, b) ((int32_t)(((uint32_t)(uint16_t)(b)<<16)|(uint16_t)(a)))
+
+#ifndef SMLALD
+// portable versions, same results as the instructions
+static int64_t Smlald(int64_t acc, int32_t x, int32_t y){
+  return acc + (int64_t)LO(x)*LO(y) + (int64_t)HI(x)*HI(y);
+}
+static int32_t Qadd16(int32_t x, int32_t y){
+  return PACK(Sat16(LO(x) + LO(y)), Sat16(HI(x) + HI(y)));
+}
+#define SMLALD(acc, x, y)  Smlald((acc), (x), (y))
+#define QADD16(x, y)       Qadd16((x), (y))
+#endif
+
+// two samples at any halfword address, one load; gcc and clang also
+// need telling that the word aliases the int16_t arrays
+#if defined(__TI_ARM__)
+struct Pair{
+  int32_t w;
+} __attribute__((packed));
+#else
+struct Pair{
+  int32_t w;
+} __attribute__((packed, may_alias));
+#endif
+#define PAIR(p) (((const struct Pair *)(p))->w)
+#define SETPAIR(p, v) (((struct Pair *)(p))->w = (v))
+
+// ******** DSP_FIRInit ************
+// set up an FIR filter, y[n] = h[0]x[n] + h[1]x[n-1] + ...; history 0
+// Inputs: filter, coefficients h (Q15), length 1 to DSP_TAPSMAX
+// Outputs: 1 if set up, 0 on a bad length
+int DSP_FIRInit(struct DSP_FIR *f, const int16_t *h, uint32_t taps){
+  uint32_t i;
+  if((taps == 0) || (taps > DSP_TAPSMAX)){
+    return 0;
+  }
+  f->taps = (taps + 3)&~3;
+  f->phase = 0;
+  for(i = 0; i < f->taps; i++){
+    // coeffs[taps-1] is h[0], it meets the newest sample
+    f->coeffs[i] = (f->taps - 1 - i < taps) ? h[f->taps - 1 - i] : 0;
+  }
+  for(i = 0; i < DSP_TAPSMAX + DSP_BLOCKMAX; i++){
+    f->state[i] = 0;
+  }
+  return 1;
+}
+
+// filter n samples, keeping the output of every factor-th one
+// the inputs of a pass are copied in before any output is written,
+// and there are never more outputs than inputs, so in and out may overlap
+static uint32_t Run(struct DSP_FIR *f, const int16_t *in, int16_t *out,
+                    uint32_t n, uint32_t factor){
+  uint32_t hist = f->taps - 1, made = 0, count, i, k;
+  const int16_t *x;
+  int64_t acc;
+  while(n){
+    count = (n < DSP_BLOCKMAX) ? n : DSP_BLOCKMAX;
+    for(i = 0; i < count; i++){
+      f->state[hist + i] = in[i];
+    }
+    for(i = 0; i < count; i++){
+      if(++f->phase < factor){
+        continue;
+      }
+      f->phase = 0;
+      x = &f->state[i];           // the taps samples ending at in[i]
+      acc = 0;
+      for(k = 0; k < f->taps; k = k + 4){
+        acc = SMLALD(acc, PAIR(&f->coeffs[k]), PAIR(&x[k]));
+        acc = SMLALD(acc, PAIR(&f->coeffs[k+2]), PAIR(&x[k+2]));
+      }
+      out[made] = Sat16((int32_t)(acc>>15));
+      made++;
+    }
+    for(i = 0; i < hist; i++){    // the newest samples become the history
+      f->state[i] = f->state[count + i];
+    }
+    in = in + count;
+    n = n - count;
+  }
+  return made;
+}
+
+// ******** DSP_FIR ************
+// filter a block; in and out may be the same array
+// Inputs: filter, n input samples, where to put the n outputs
+// Outputs: none
+void DSP_FIR(struct DSP_FIR *f, const int16_t *in, int16_t *out, uint32_t n){
+  f->phase = 0;
+  Run(f, in, out, n, 1);
+}
+
+// ******** DSP_Decimate ************
+// filter a block and keep every factor-th output, so h should cut off
+// below the new Nyquist frequency; blocks need not be multiples of
+// factor, the phase carries over to the next call
+// Inputs: filter, n input samples, where to put the outputs, factor
+//         (1 or more)
+// Outputs: number of outputs written, at most n/factor rounded up
+uint32_t DSP_Decimate(struct DSP_FIR *f, const int16_t *in, int16_t *out,
+                      uint32_t n, uint32_t factor){
+  if(factor == 0){
+    factor = 1;
+  }
+  return Run(f, in, out, n, factor);
+}
+
+// -a, which Q2.14 can hold unless a is -2.0
+static int16_t Neg(int16_t a){
+  return (a == Q15MIN) ? Q15MAX : -a;
+}
+
+// ******** DSP_BiquadInit ************
+// set up one second-order section,
+//   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+// coefficients in Q2.14 (16384 is 1.0), history 0
+// Inputs: section, b0, b1, b2, a1, a2
+// Outputs: none
+void DSP_BiquadInit(struct DSP_Biquad *s, int16_t b0, int16_t b1, int16_t b2,
+                    int16_t a1, int16_t a2){
+  s->b0 = b0;
+  s->b12 = PACK(b1, b2);
+  s->a12 = PACK(Neg(a1), Neg(a2));
+  s->x = 0;
+  s->y = 0;
+}
+
+// ******** DSP_Biquad ************
+// filter a block through a cascade of sections, first to last; each
+// section's output saturates to Q15; in and out may be the same array
+// one section at a time over the whole block, so its history and
+// coefficients stay in registers; five taps take one multiply and two
+// SMLALDs, and shifting the history along is one pack per pair
+// Inputs: sections, how many, n input samples, where to put n outputs
+// Outputs: none
+void DSP_Biquad(struct DSP_Biquad *s, uint32_t stages, const int16_t *in,
+                int16_t *out, uint32_t n){
+  uint32_t i;
+  int32_t b0, b12, a12, x, y;
+  int16_t v, w;
+  int64_t acc;
+  while(stages){
+    b0 = s->b0; b12 = s->b12; a12 = s->a12;
+    x = s->x; y = s->y;
+    for(i = 0; i < n; i++){
+      v = in[i];
+      acc = (int64_t)b0*v;
+      acc = SMLALD(acc, b12, x);
+      acc = SMLALD(acc, a12, y);
+      w = Sat16((int32_t)(acc>>DSP_BIQUAD_Q));
+      x = PACK(v, x);             // x[n-1] moves up to x[n-2]
+      y = PACK(w, y);
+      out[i] = w;
+    }
+    s->x = x; s->y = y;
+    in = out;                     // the next section filters this output
+    s++;
+    stages--;
+  }
+}
+
+// ******** DSP_AverageInit ************
+// Inputs: moving average, window 1 to DSP_AVGMAX samples
+// Outputs: 1 if set up, 0 on a bad window
+int DSP_AverageInit(struct DSP_Average *a, uint32_t size){
+  uint32_t i;
+  if((size == 0) || (size > DSP_AVGMAX)){
+    return 0;
+  }
+  a->sum = 0;
+  a->size = size;
+  a->next = 0;
+  for(i = 0; i < size; i++){
+    a->x[i] = 0;
+  }
+  return 1;
+}
+
+// ******** DSP_Average ************
+// moving average of a block, each output the mean of the last size
+// inputs (the window starts out full of 0); in and out may be the same
+// a running sum, so the cost per sample doesn't grow with the window
+// Inputs: moving average, n input samples, where to put n outputs
+// Outputs: none
+void DSP_Average(struct DSP_Average *a, const int16_t *in, int16_t *out,
+                 uint32_t n){
+  uint32_t i, next = a->next;
+  int32_t sum = a->sum;
+  int16_t v;
+  for(i = 0; i < n; i++){
+    v = in[i];
+    sum = sum + v - a->x[next];
+    a->x[next] = v;
+    next++;
+    if(next == a->size){
+      next = 0;
+    }
+    out[i] = (int16_t)(sum/(int32_t)a->size);
+  }
+  a->next = next;
+  a->sum = sum;
+}
+
+// ******** DSP_AverageQ31Init ************
+// Inputs: moving average, window 1 to DSP_AVGMAX samples
+// Outputs: 1 if set up, 0 on a bad window
+int DSP_AverageQ31Init(struct DSP_AverageQ31 *a, uint32_t size){
+  uint32_t i;
+  if((size == 0) || (size > DSP_AVGMAX)){
+    return 0;
+  }
+  a->sum = 0;
+  a->size = size;
+  a->next = 0;
+  for(i = 0; i < size; i++){
+    a->x[i] = 0;
+  }
+  return 1;
+}
+
+// ******** DSP_AverageQ31 ************
+// add one sample to a 32-bit moving average, for values too wide for
+// Q15 such as capture intervals in bus cycles
+// Inputs: moving average, new sample
+// Outputs: mean of the last size samples
+int32_t DSP_AverageQ31(struct DSP_AverageQ31 *a, int32_t x){
+  a->sum = a->sum + x - a->x[a->next];
+  a->x[a->next] = x;
+  a->next++;
+  if(a->next == a->size){
+    a->next = 0;
+  }
+  return (int32_t)(a->sum/(int32_t)a->size);
+}
+
+// ******** DSP_Add ************
+// out[i] = a[i] + b[i], saturating at the Q15 limits; out may be a or b
+// two samples per QADD16
+// Inputs: two blocks, where to put the sum, n samples
+// Outputs: none
+void DSP_Add(const int16_t *a, const int16_t *b, int16_t *out, uint32_t n){
+  uint32_t i;
+  for(i = 0; i + 1 < n; i = i + 2){
+    SETPAIR(&out[i], QADD16(PAIR(&a[i]), PAIR(&b[i])));
+  }
+  if(i < n){
+    out[i] = Sat16(a[i] + b[i]);
+  }
+}
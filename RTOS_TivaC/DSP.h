@@ -0,0 +1,121 @@
+// DSP.h
+// Runs on TM4C123, or any C compiler
+// Fixed-point filters for sensor data: FIR, decimating FIR, biquad IIR
+// cascade, moving average and a saturating add.  Samples are Q15
+// (int16_t, -1 to 1-2^-15) unless the name says Q31 (int32_t).
+// On the Cortex-M4 the inner loops use the dual 16-bit multiply
+// accumulate (SMLALD) and saturating add (QADD16), two samples per
+// instruction; other compilers get the same arithmetic in plain C, so
+// the results match bit for bit on the host.
+// Filters keep their own history, so a stream can be fed in blocks of
+// any length (ADC_Wait buffers, for one) and comes out as if filtered
+// one sample at a time.  A filter is used by one thread at a time.
+
+#ifndef __DSP_H__
+#define __DSP_H__
+
+#include <stdint.h>
+
+#define DSP_TAPSMAX   32         // FIR length, at most
+#define DSP_BLOCKMAX  64         // samples filtered per pass of the FIR
+#define DSP_AVGMAX    64         // moving average window, at most
+#define DSP_BIQUAD_Q  14         // biquad coefficients are Q2.14 (-2 to 2)
+
+struct DSP_FIR{
+  uint32_t taps;                          // multiple of 4, padded with 0 taps
+  uint32_t phase;                         // samples into the decimation
+  int16_t coeffs[DSP_TAPSMAX];            // reversed, oldest sample first
+  int16_t state[DSP_TAPSMAX+DSP_BLOCKMAX];// history, then the block
+};
+
+struct DSP_Biquad{
+  int32_t b12;               // b1 low half, b2 high half
+  int32_t a12;               // -a1 low half, -a2 high half
+  int32_t b0;
+  int32_t x;                 // x[n-1] low half, x[n-2] high half
+  int32_t y;                 // y[n-1] low half, y[n-2] high half
+};
+
+struct DSP_Average{
+  int32_t sum;
+  uint32_t size, next;
+  int16_t x[DSP_AVGMAX];
+};
+
+struct DSP_AverageQ31{
+  int64_t sum;
+  uint32_t size, next;
+  int32_t x[DSP_AVGMAX];
+};
+
+// ******** DSP_FIRInit ************
+// set up an FIR filter, y[n] = h[0]x[n] + h[1]x[n-1] + ...; history 0
+// Inputs: filter, coefficients h (Q15), length 1 to DSP_TAPSMAX
+// Outputs: 1 if set up, 0 on a bad length
+int DSP_FIRInit(struct DSP_FIR *f, const int16_t *h, uint32_t taps);
+
+// ******** DSP_FIR ************
+// filter a block; in and out may be the same array
+// Inputs: filter, n input samples, where to put the n outputs
+// Outputs: none
+void DSP_FIR(struct DSP_FIR *f, const int16_t *in, int16_t *out, uint32_t n);
+
+// ******** DSP_Decimate ************
+// filter a block and keep every factor-th output, so h should cut off
+// below the new Nyquist frequency; blocks need not be multiples of
+// factor, the phase carries over to the next call
+// Inputs: filter, n input samples, where to put the outputs, factor
+//         (1 or more)
+// Outputs: number of outputs written, at most n/factor rounded up
+uint32_t DSP_Decimate(struct DSP_FIR *f, const int16_t *in, int16_t *out,
+                      uint32_t n, uint32_t factor);
+
+// ******** DSP_BiquadInit ************
+// set up one second-order section,
+//   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+// coefficients in Q2.14 (16384 is 1.0), history 0
+// Inputs: section, b0, b1, b2, a1, a2
+// Outputs: none
+void DSP_BiquadInit(struct DSP_Biquad *s, int16_t b0, int16_t b1, int16_t b2,
+                    int16_t a1, int16_t a2);
+
+// ******** DSP_Biquad ************
+// filter a block through a cascade of sections, first to last; each
+// section's output saturates to Q15; in and out may be the same array
+// Inputs: sections, how many, n input samples, where to put n outputs
+// Outputs: none
+void DSP_Biquad(struct DSP_Biquad *s, uint32_t stages, const int16_t *in,
+                int16_t *out, uint32_t n);
+
+// ******** DSP_AverageInit ************
+// Inputs: moving average, window 1 to DSP_AVGMAX samples
+// Outputs: 1 if set up, 0 on a bad window
+int DSP_AverageInit(struct DSP_Average *a, uint32_t size);
+
+// ******** DSP_Average ************
+// moving average of a block, each output the mean of the last size
+// inputs (the window starts out full of 0); in and out may be the same
+// Inputs: moving average, n input samples, where to put n outputs
+// Outputs: none
+void DSP_Average(struct DSP_Average *a, const int16_t *in, int16_t *out,
+                 uint32_t n);
+
+// ******** DSP_AverageQ31Init ************
+// Inputs: moving average, window 1 to DSP_AVGMAX samples
+// Outputs: 1 if set up, 0 on a bad window
+int DSP_AverageQ31Init(struct DSP_AverageQ31 *a, uint32_t size);
+
+// ******** DSP_AverageQ31 ************
+// add one sample to a 32-bit moving average, for values too wide for
+// Q15 such as capture intervals in bus cycles
+// Inputs: moving average, new sample
+// Outputs: mean of the last size samples
+int32_t DSP_AverageQ31(struct DSP_AverageQ31 *a, int32_t x);
+
+// ******** DSP_Add ************
+// out[i] = a[i] + b[i], saturating at the Q15 limits; out may be a or b
+// Inputs: two blocks, where to put the sum, n samples
+// Outputs: none
+void DSP_Add(const int16_t *a, const int16_t *b, int16_t *out, uint32_t n);
+
+#endif
@@ -0,0 +1,459 @@
+// Encoder.c
+// Runs on TM4C123
+// DC motor speed from its encoder, see Encoder.h.  Wide Timer0A
+// captures with a 32-bit count, 537 s at 8 MHz, and the Timer driver
+// extends the timestamps past that with the count of wrap-arounds.
+// The edge interrupt only records the timestamp.  Encoder_Latch, in
+// the interrupt that paces the window, copies the window's end: the
+// edge count, the last timestamps and the time.  The divides and the
+// filter run in Encoder_Thread from that copy, in integer 1/100 RPM,
+// so a thread that runs late only merges windows, it loses no edges
+// and doesn't change when a window ended.
+// Above ENCODER_POLL_RATE the edge interrupt turns itself off, the way
+// NAPI network drivers do: it switches the timer to edge counting, and
+// Encoder_Latch reads the count in one batch every window.  The rate
+// is edges over the time between their own timestamps, a count that
+// starts over whenever it spans more than a window, so it doesn't
+// depend on when the samples run.  When a window's edges come slower
+// than ENCODER_IRQ_RATE, over the time the window really took,
+// Encoder_Sample switches back to timestamping.  So a fast motor costs
+// one read per window, not one interrupt per edge, and the interrupt
+// can't starve the threads.
+// Confidence: each sample is rated 100 when counted or stalled, 75 from
+// a period that ended in the window and 25 when no edge came (the
+// speed is only an upper bound).  The filter output's confidence is the
+// average rating, reduced by the spread of the samples.
+// A bus clock change (PLL_SetFrequency) moves the remembered edge and
+// poll times back so that the time since them, measured from the
+// switch, is in cycles of the new clock; intervals that span the
+// switch then come out right.
+// A stalled encoder lets Wide Timer0 stand still through a deep sleep
+// (BSP_DeepClient).  The timestamps then skip the sleep, which only
+// makes a stall that is already longer than ENCODER_STALL_MS look
+// shorter, and an edge in the sleep isn't captured; the motor isn't
+// turning, so that edge would only have started a period.
+
+// Adapted from Program 8.2 from the book:
+/* "Embedded Systems: Introduction to ARM Cortex-M Microcontrollers",
+   ISBN: 978-1477508992, Jonathan Valvano, copyright (c) 2013
+   Volume 1, Program 9.8
+*/
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "BSP.h"
+#include "Clock.h"
+#include "Encoder.h"
+#include "PLL.h"
+#include "Timer.h"
+#include "os.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+
+#define ENCODER_TIMER WTIMER_0
+#define POLLEDGES (ENCODER_POLL_RATE*ENCODER_WINDOW_MS/1000) // per window
+
+static uint32_t BusFreq;        // Hz, from PLL_BusClock
+static uint64_t StallCycles;    // ENCODER_STALL_MS in bus cycles
+static uint64_t WindowCycles;   // ENCODER_WINDOW_MS in bus cycles
+
+// written by the edge interrupt
+static uint64_t LastEdge;       // timestamp of the latest edge
+static uint32_t Interval;       // bus cycles between the last two edges
+static uint32_t Edges;          // 0, 1, then 2 once Interval is valid
+static uint32_t EdgeCount;      // all edges, wraps around
+static uint64_t RateEdge;       // timestamp the rate count started at
+static uint32_t RateCount;      // EdgeCount then
+static volatile uint8_t Mode;   // ENCODER_IRQ or ENCODER_POLL
+
+// the end of the latest window, written by Encoder_Latch
+struct latch{
+  uint32_t time;                // BSP_Cycles
+  uint32_t count;               // EdgeCount, the timer's count polling
+  uint64_t last;                // LastEdge
+  uint64_t now;                 // Timer_Now64
+  uint32_t interval;            // Interval
+  uint32_t edges;               // Edges
+  uint8_t mode;                 // Mode
+};
+static struct latch Latched;
+static volatile uint32_t Latches; // Encoder_Latch runs, wraps
+static uint32_t Taken;          // Latches at the last Encoder_Sample
+volatile uint32_t Encoder_Late;
+
+// the estimator's state, Encoder_Sample only
+static uint32_t PrevCount;      // EdgeCount at the previous sample
+static uint64_t PrevEdge;       // LastEdge at the previous sample
+static uint8_t Primed;          // PrevEdge is an edge
+static volatile uint8_t Restart;// Encoder_SetFilter changed the filter
+static uint32_t Kind = ENCODER_AVERAGE;
+static uint32_t Length = 4;
+static uint32_t Raw[ENCODER_FILTERMAX];
+static uint8_t Rating[ENCODER_FILTERMAX];
+static uint32_t Next;           // where the next sample goes
+static uint32_t Fill;           // samples in the filter
+static uint8_t Hold;            // back from polling, no period yet
+static uint32_t PollCount;      // edge count at the last poll
+static uint32_t PollTime;       // BSP_Cycles at the last poll
+static uint32_t PollPeriod;     // average bus cycles per edge then
+static uint32_t SampleTime;     // BSP_Cycles at the previous sample
+static uint64_t ModeCycles[2];  // bus cycles spent in each mode
+volatile uint32_t Encoder_IrqMs, Encoder_PollMs, Encoder_Switches;
+
+// the result
+static volatile uint32_t Speed;
+static volatile uint32_t Confidence;
+
+static void Edge(uint32_t timer, uint32_t stamp);
+
+// too many edges this window: count them in hardware instead
+// called from the edge interrupt
+static void GoPoll(void){
+  Timer_EdgeCount(ENCODER_TIMER, TIMER_RISING, ENCODER_PRI); // no per edge
+  PollCount = Timer_Read(ENCODER_TIMER);
+  PollTime = BSP_Cycles();
+  PollPeriod = Interval;
+  Mode = ENCODER_POLL;
+  Encoder_Switches++;
+}
+
+// few edges again: back to one timestamp per edge
+// called from Encoder_Sample
+static void GoIrq(void){
+  uint32_t sr = StartCritical();
+  Edges = 0;                    // the timestamps start over
+  LastEdge = 0;
+  Primed = 0;
+  Hold = 1;
+  PrevCount = RateCount = EdgeCount;
+  RateEdge = 0;
+  Mode = ENCODER_IRQ;
+  Encoder_Switches++;
+  Timer_Capture(ENCODER_TIMER, TIMER_RISING, ENCODER_PRI, &Edge);
+  EndCritical(sr);
+}
+
+// one encoder edge
+static void Edge(uint32_t timer, uint32_t stamp){
+  uint64_t now = Timer_Read64(timer);
+  uint64_t interval = now - LastEdge;
+  LastEdge = now;
+  Interval = (interval > StallCycles) ? 0 : (uint32_t)interval;
+  EdgeCount++;
+  if(Edges < 2){
+    Edges++;
+  }
+  if(now - RateEdge > WindowCycles){
+    RateEdge = now;             // too slow over a window, count anew
+    RateCount = EdgeCount;
+  } else if(EdgeCount - RateCount >= POLLEDGES){
+    GoPoll();                   // a window's worth in a window or less
+  }
+}
+
+// n edges in the given bus cycles, in 1/ENCODER_SCALE RPM
+// (edges per second * 60 seconds in a minute) / 120:1 gear ratio
+static uint32_t ToSpeed(uint32_t n, uint64_t cycles){
+  return (uint32_t)(((uint64_t)n*BusFreq*60*ENCODER_SCALE)/
+                    (cycles*ENCODER_GEAR));
+}
+
+// when an event span old bus cycles before now, in new bus cycles
+// (modulo 2^64, so only differences from it are meaningful); spans
+// past a stall are all the same, so they are cut there first
+static uint64_t Back(uint64_t now, uint64_t then, uint32_t from, uint32_t to){
+  uint64_t span = now - then;
+  if(span > StallCycles){
+    span = StallCycles + 1;
+  }
+  return now - span*to/from;
+}
+
+// new bus clock, called by PLL_SetFrequency with interrupts disabled
+static void Retime(uint32_t from, uint32_t to){
+  uint32_t cycles = BSP_Cycles();
+  uint64_t now;
+  if(Mode == ENCODER_IRQ){
+    now = Timer_Now64(ENCODER_TIMER);
+    LastEdge = Back(now, LastEdge, from, to);
+    PrevEdge = Back(now, PrevEdge, from, to);
+    RateEdge = Back(now, RateEdge, from, to);
+  }
+  Interval = (uint32_t)((uint64_t)Interval*to/from);
+  PollPeriod = (uint32_t)((uint64_t)PollPeriod*to/from);
+  PollTime = cycles - (uint32_t)((uint64_t)(cycles - PollTime)*to/from);
+  SampleTime = cycles - (uint32_t)((uint64_t)(cycles - SampleTime)*to/from);
+  Taken = Latches;              // old cycles; the next window covers it
+  BusFreq = to;
+  StallCycles = (uint64_t)to*ENCODER_STALL_MS/1000;
+  WindowCycles = (uint64_t)to*ENCODER_WINDOW_MS/1000;
+}
+
+// deep sleep client: idle while stalled
+static int Park(int sleep){
+  return Encoder_Stalled();     // nothing to stop or restart
+}
+
+// ******** Encoder_Init ************
+// set up PC4 and start timestamping edges; interrupts are enabled
+// later, by OS_Launch; the filter starts as a 4-sample average
+// Inputs: none
+// Outputs: none
+void Encoder_Init(void){
+  BusFreq = PLL_BusClock();
+  StallCycles = (uint64_t)BusFreq*ENCODER_STALL_MS/1000;
+  WindowCycles = (uint64_t)BusFreq*ENCODER_WINDOW_MS/1000;
+  PLL_Register(&Retime);
+  LastEdge = PrevEdge = RateEdge = 0;
+  Interval = 0;
+  Edges = EdgeCount = PrevCount = RateCount = 0;
+  Latches = Taken = Encoder_Late = 0;
+  Primed = 0;
+  Speed = Confidence = 0;
+  Mode = ENCODER_IRQ;
+  Hold = 0;
+  ModeCycles[ENCODER_IRQ] = ModeCycles[ENCODER_POLL] = 0;
+  Encoder_IrqMs = Encoder_PollMs = Encoder_Switches = 0;
+  SampleTime = BSP_Cycles();
+  Encoder_SetFilter(ENCODER_AVERAGE, 4);
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTC);
+  GPIO_PORTC_DIR_R &= ~0x10;                 // PC4 input
+  GPIO_PORTC_AMSEL_R &= ~0x10;
+  GPIO_PORTC_DEN_R |= 0x10;                  // enable digital I/O on PC4
+  GPIO_PORTC_AFSEL_R |= 0x10;                // alternate function on PC4
+  GPIO_PORTC_PCTL_R = (GPIO_PORTC_PCTL_R&0xFFF0FFFF)|0x00070000; // WT0CCP0
+  if(Timer_Open(ENCODER_TIMER, "encoder")){
+    Timer_Capture(ENCODER_TIMER, TIMER_RISING, ENCODER_PRI, &Edge);
+  }
+  BSP_DeepClient(CLOCK_WTIMER, 1u<<(ENCODER_TIMER - WTIMER_0), &Park);
+}
+
+// ******** Encoder_SetFilter ************
+// choose the filter and restart it
+// Inputs: ENCODER_AVERAGE or ENCODER_MEDIAN, samples 1 to
+//         ENCODER_FILTERMAX (1 turns filtering off)
+// Outputs: none
+void Encoder_SetFilter(uint32_t kind, uint32_t length){
+  Kind = kind;
+  Length = (length < 1) ? 1 : (length > ENCODER_FILTERMAX) ? ENCODER_FILTERMAX : length;
+  Restart = 1;                  // the estimator empties the filter
+}
+
+// middle of the samples in the filter
+static uint32_t Median(void){
+  uint32_t sorted[ENCODER_FILTERMAX];
+  uint32_t i, j, v;
+  for(i = 0; i < Fill; i++){    // insertion sort, at most 9
+    v = Raw[i];
+    for(j = i; (j > 0) && (sorted[j-1] > v); j--){
+      sorted[j] = sorted[j-1];
+    }
+    sorted[j] = v;
+  }
+  return sorted[Fill/2];
+}
+
+// add a sample, update Speed and Confidence
+static void Filter(uint32_t raw, uint32_t rating){
+  uint32_t i, out, lo, hi, ratings = 0;
+  uint64_t sum = 0;
+  uint32_t conf, sr;
+  if(Restart){
+    Restart = 0;
+    Next = Fill = 0;
+  }
+  Raw[Next] = raw;
+  Rating[Next] = rating;
+  Next = (Next + 1)%Length;
+  if(Fill < Length){
+    Fill++;
+  }
+  lo = hi = Raw[0];
+  for(i = 0; i < Fill; i++){
+    sum += Raw[i];
+    ratings += Rating[i];
+    if(Raw[i] < lo) lo = Raw[i];
+    if(Raw[i] > hi) hi = Raw[i];
+  }
+  out = (Kind == ENCODER_MEDIAN) ? Median() : (uint32_t)(sum/Fill);
+  conf = ratings/Fill;
+  if(hi){                       // a spread of half the top value halves it
+    conf = conf - (uint32_t)((uint64_t)conf*(hi - lo)/(2*(uint64_t)hi));
+  }
+  conf = conf*Fill/Length;      // not yet a full filter
+  sr = StartCritical();         // a matching pair for Encoder_Speed
+  Speed = out;
+  Confidence = conf;
+  EndCritical(sr);
+}
+
+// one window while polling: the edges counted in hardware
+static void SamplePoll(const struct latch *l){
+  uint32_t time = l->time;
+  uint32_t count = l->count;
+  uint32_t n = count - PollCount;
+  uint32_t cycles = time - PollTime;
+  PollCount = count;
+  PollTime = time;
+  if(cycles == 0){
+    return;
+  }
+  PollPeriod = n ? cycles/n : 0;
+  Filter(ToSpeed(n, cycles), 100);
+  if((uint64_t)n*BusFreq < (uint64_t)ENCODER_IRQ_RATE*cycles){
+    GoIrq();                    // slower than ENCODER_IRQ_RATE edges/s
+  }
+}
+
+// one window while timestamping
+static void SampleIrq(const struct latch *l){
+  uint32_t count = l->count, interval = l->interval, edges = l->edges;
+  uint32_t n, raw, rating;
+  uint64_t last = l->last, now = l->now, since;
+  n = count - PrevCount;
+  since = now - last;
+  if(Hold){
+    if((edges < 2) && (now <= StallCycles)){
+      PrevCount = count;        // keep the speed from the polling
+      return;
+    }
+    Hold = 0;
+  }
+  if((n >= ENCODER_MINEDGES) && Primed){
+    raw = ToSpeed(n, last - PrevEdge); // edges since the previous window's last
+    rating = 100;
+  } else if((edges < 2) || (since > StallCycles) || (interval == 0)){
+    raw = 0;                           // stalled
+    rating = 100;
+  } else if(since > interval){
+    raw = ToSpeed(1, since);           // slowing down, at most this fast
+    rating = 25;
+  } else{
+    raw = ToSpeed(1, interval);
+    rating = n ? 75 : 25;
+  }
+  PrevCount = count;
+  PrevEdge = last;
+  Primed = (edges > 0);
+  Filter(raw, rating);
+}
+
+// ******** Encoder_Latch ************
+// end the window, every ENCODER_WINDOW_MS from a periodic interrupt
+// Inputs: none
+// Outputs: none
+void Encoder_Latch(void){
+  uint32_t sr = StartCritical();  // a matching set, the edge interrupt is above
+  Latched.time = BSP_Cycles();
+  Latched.mode = Mode;
+  if(Mode == ENCODER_POLL){
+    Latched.count = Timer_Read(ENCODER_TIMER);
+  } else{
+    Latched.count = EdgeCount;
+    Latched.last = LastEdge;
+    Latched.interval = Interval;
+    Latched.edges = Edges;
+    Latched.now = Timer_Now64(ENCODER_TIMER);
+  }
+  Latches++;
+  EndCritical(sr);
+}
+
+// ******** Encoder_Sample ************
+// one estimator step over the windows latched since the last one
+// Inputs: none
+// Outputs: none
+void Encoder_Sample(void){
+  struct latch l;
+  uint32_t sr, n, msCycles;
+  sr = StartCritical();
+  l = Latched;
+  n = Latches - Taken;
+  Taken = Latches;
+  EndCritical(sr);
+  if(n == 0){
+    return;                     // no window ended since the last step
+  }
+  Encoder_Late += n - 1;        // windows merged into this one
+  msCycles = BusFreq/1000;
+  ModeCycles[l.mode] += l.time - SampleTime; // the window goes to its mode
+  SampleTime = l.time;
+  Encoder_IrqMs = (uint32_t)(ModeCycles[ENCODER_IRQ]/msCycles);
+  Encoder_PollMs = (uint32_t)(ModeCycles[ENCODER_POLL]/msCycles);
+  if(l.mode == ENCODER_POLL){
+    if(Mode == ENCODER_IRQ){
+      return;                   // latched before GoIrq, counts from there
+    }
+    SamplePoll(&l);
+  } else{
+    SampleIrq(&l);
+  }
+}
+
+// ******** Encoder_Thread ************
+// the estimator, add it with OS_AddThread; never returns
+// Inputs: none
+// Outputs: none
+void Encoder_Thread(void){
+  for(;;){
+    OS_Sleep(ENCODER_WINDOW_MS);
+    Encoder_Sample();
+  }
+}
+
+// ******** Encoder_Mode ************
+// Inputs: none
+// Outputs: ENCODER_IRQ or ENCODER_POLL
+uint32_t Encoder_Mode(void){
+  return Mode;
+}
+
+// ******** Encoder_Speed ************
+// filtered output shaft speed
+// Inputs: where to put the confidence, 0 (nothing known) to 100
+//         (may be 0)
+// Outputs: speed in 1/ENCODER_SCALE RPM
+uint32_t Encoder_Speed(uint32_t *confidence){
+  uint32_t sr = StartCritical();
+  uint32_t speed = Speed;
+  if(confidence){
+    *confidence = Confidence;
+  }
+  EndCritical(sr);
+  return speed;
+}
+
+// ******** Encoder_RPM ************
+// Inputs: none
+// Outputs: filtered output shaft speed, rounded to RPM
+uint32_t Encoder_RPM(void){
+  return (Encoder_Speed(0) + ENCODER_SCALE/2)/ENCODER_SCALE;
+}
+
+// ******** Encoder_Period ************
+// Inputs: none
+// Outputs: bus cycles between the last two edges (the average over the
+//          last window while polling), 0 when stalled
+uint32_t Encoder_Period(void){
+  uint32_t sr, interval;
+  uint64_t last;
+  if(Mode == ENCODER_POLL){
+    return PollPeriod;          // average over the last window
+  }
+  sr = StartCritical();
+  interval = (Edges < 2) ? 0 : Interval;
+  last = LastEdge;
+  EndCritical(sr);
+  if(Timer_Now64(ENCODER_TIMER) - last > StallCycles){
+    return 0;
+  }
+  return interval;
+}
+
+// ******** Encoder_Stalled ************
+// Inputs: none
+// Outputs: 1 if no edge came for ENCODER_STALL_MS (or none yet)
+int Encoder_Stalled(void){
+  return Encoder_Period() == 0;
+}
@@ -0,0 +1,125 @@
+// Encoder.h
+// Runs on TM4C123
+// DC motor speed from its encoder on PC4 (WT0CCP0).  Wide Timer0A
+// timestamps every rising edge through the Timer driver with 64-bit,
+// wrap-safe timestamps, and that is all the edge interrupt does.
+// Encoder_Latch, run every ENCODER_WINDOW_MS from a periodic interrupt
+// (the motor control loop), copies the window's edge count and
+// timestamps, and Encoder_Thread turns them into a speed:
+//   ENCODER_MINEDGES or more edges in the window: edges counted over
+//     the time from the window's first edge to its last (high speed)
+//   fewer: the period between the last two edges, bounded by the time
+//     since the last edge, so a slowing motor reads slower (low speed)
+//   no edge for ENCODER_STALL_MS: stalled, speed 0
+// and runs the samples through a moving-average or median filter.
+// Above ENCODER_POLL_RATE edges per second, measured over at most a
+// window of the edges' own timestamps, the per-edge interrupt is
+// turned off and the timer counts the edges, read once per window;
+// below ENCODER_IRQ_RATE the timestamps come back.
+
+// Adapted from Program 8.2 from the book:
+/* "Embedded Systems: Introduction to ARM Cortex-M Microcontrollers",
+   ISBN: 978-1477508992, Jonathan Valvano, copyright (c) 2013
+   Volume 1, Program 9.8
+*/
+
+#ifndef __ENCODER_H__
+#define __ENCODER_H__
+
+#include <stdint.h>
+
+#define ENCODER_PRI       2     // capture interrupt priority
+#define ENCODER_GEAR      120   // motor turns per output shaft turn
+#define ENCODER_STALL_MS  500   // longer without an edge is a stall
+#define ENCODER_WINDOW_MS 10    // estimator sample period, the motor
+                                // control period (Motor.h)
+#define ENCODER_MINEDGES  4     // edges per window to count them
+#define ENCODER_FILTERMAX 9     // longest filter, in samples
+#define ENCODER_SCALE     100   // speeds are in 1/100 RPM
+#define ENCODER_POLL_RATE 4000  // edges/s to stop interrupting per edge
+#define ENCODER_IRQ_RATE  2000  // edges/s to go back, for hysteresis
+
+// modes, see Encoder_Mode
+#define ENCODER_IRQ       0     // one timestamp interrupt per edge
+#define ENCODER_POLL      1     // edges counted, read every window
+
+// filters for Encoder_SetFilter
+#define ENCODER_AVERAGE   0
+#define ENCODER_MEDIAN    1
+
+// ******** Encoder_Init ************
+// set up PC4 and start timestamping edges; interrupts are enabled
+// later, by OS_Launch; the filter starts as a 4-sample average
+// timestamps are in bus cycles, scaled by PLL_BusClock
+// Inputs: none
+// Outputs: none
+void Encoder_Init(void);
+
+// ******** Encoder_SetFilter ************
+// choose the filter and restart it
+// Inputs: ENCODER_AVERAGE or ENCODER_MEDIAN, samples 1 to
+//         ENCODER_FILTERMAX (1 turns filtering off)
+// Outputs: none
+void Encoder_SetFilter(uint32_t kind, uint32_t length);
+
+// ******** Encoder_Latch ************
+// end the window: copy its edge count and timestamps for the estimator;
+// run it every ENCODER_WINDOW_MS from a periodic interrupt below
+// ENCODER_PRI, so the windows end on time whenever the estimator runs;
+// constant, small cost, no divides
+// Inputs: none
+// Outputs: none
+void Encoder_Latch(void);
+
+// ******** Encoder_Thread ************
+// the estimator, filter and confidence over the latched windows, add it
+// with OS_AddThread; never returns
+// Inputs: none
+// Outputs: none
+void Encoder_Thread(void);
+
+// ******** Encoder_Sample ************
+// one estimator step, what Encoder_Thread runs every window, for
+// callers without the kernel; covers every window latched since the
+// previous step, none if there wasn't one
+// Inputs: none
+// Outputs: none
+void Encoder_Sample(void);
+
+// ******** Encoder_Speed ************
+// filtered output shaft speed
+// Inputs: where to put the confidence, 0 (nothing known) to 100
+//         (may be 0)
+// Outputs: speed in 1/ENCODER_SCALE RPM
+uint32_t Encoder_Speed(uint32_t *confidence);
+
+// ******** Encoder_RPM ************
+// Inputs: none
+// Outputs: filtered output shaft speed, rounded to RPM
+uint32_t Encoder_RPM(void);
+
+// ******** Encoder_Mode ************
+// Inputs: none
+// Outputs: ENCODER_IRQ or ENCODER_POLL
+uint32_t Encoder_Mode(void);
+
+// time spent in each mode, in ms (counted per window), and the number
+// of switches between them
+extern volatile uint32_t Encoder_IrqMs, Encoder_PollMs, Encoder_Switches;
+
+// windows the estimator took only together with the next one, because
+// Encoder_Thread ran late
+extern volatile uint32_t Encoder_Late;
+
+// ******** Encoder_Stalled ************
+// Inputs: none
+// Outputs: 1 if no edge came for ENCODER_STALL_MS (or none yet)
+int Encoder_Stalled(void);
+
+// ******** Encoder_Period ************
+// Inputs: none
+// Outputs: bus cycles between the last two edges (the average over the
+//          last window while polling), 0 when stalled
+uint32_t Encoder_Period(void);
+
+#endif
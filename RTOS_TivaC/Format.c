@@ -0,0 +1,169 @@
+// Format.c
+// Runs on TM4C123 or the QEMU mps2-an386 machine
+// Integer and fixed-point to text, see Format.h.
+// No recursion and no divide instruction: a 32-bit number is split two
+// digits at a time with a multiply by the reciprocal of 100 (UMULL and
+// a shift, exact for every 32-bit value), and each pair is copied from
+// a 200-character table.
+
+#include <stdint.h>
+#include "Format.h"
+
+// "00" to "99"
+static const char Pairs[200] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const char Hex[16] = "0123456789ABCDEF";
+
+// n/100 for any 32-bit n, ceil(2^37/100) is the reciprocal
+static uint32_t Div100(uint32_t n){
+  return (uint32_t)(((uint64_t)n*0x51EB851Fu)>>37);
+}
+
+// digits of n, right aligned so they end at end; returns the first
+static char *Digits(char *end, uint32_t n){
+  uint32_t q, r;
+  while(n >= 100){
+    q = Div100(n);
+    r = 2*(n - 100*q);
+    end -= 2;
+    end[0] = Pairs[r];
+    end[1] = Pairs[r+1];
+    n = q;
+  }
+  if(n >= 10){
+    end -= 2;
+    end[0] = Pairs[2*n];
+    end[1] = Pairs[2*n+1];
+  } else{
+    end--;
+    *end = '0'+n;
+  }
+  return end;
+}
+
+static uint32_t Copy(char *buf, const char *pt, const char *end){
+  uint32_t len = end - pt;
+  uint32_t i;
+  for(i = 0; i < len; i++){
+    buf[i] = pt[i];
+  }
+  buf[len] = 0;
+  return len;
+}
+
+// ******** Fmt_UDec ************
+// unsigned decimal, 1 to 10 digits
+// Inputs: buffer, number
+// Outputs: length
+uint32_t Fmt_UDec(char *buf, uint32_t n){
+  char tmp[10];
+  return Copy(buf, Digits(&tmp[10], n), &tmp[10]);
+}
+
+// ******** Fmt_Dec ************
+// signed decimal, '-' and 1 to 10 digits
+// Inputs: buffer, number
+// Outputs: length
+uint32_t Fmt_Dec(char *buf, int32_t n){
+  char tmp[11];
+  char *pt = Digits(&tmp[11], (n < 0) ? -(uint32_t)n : (uint32_t)n);
+  if(n < 0){
+    pt--;
+    *pt = '-';
+  }
+  return Copy(buf, pt, &tmp[11]);
+}
+
+// ******** Fmt_UHex ************
+// unsigned hexadecimal, 1 to 8 digits, capitals
+// Inputs: buffer, number
+// Outputs: length
+uint32_t Fmt_UHex(char *buf, uint32_t n){
+  char tmp[8];
+  char *pt = &tmp[8];
+  do{
+    pt--;
+    *pt = Hex[n&0x0F];
+    n = n>>4;
+  } while(n);
+  return Copy(buf, pt, &tmp[8]);
+}
+
+// fixed point from the magnitude's digits, with the sign if negative
+static uint32_t Fix(char *buf, uint32_t u, int negative, uint32_t decimals){
+  char tmp[FMT_BUFSIZE];
+  char *end = &tmp[FMT_BUFSIZE];
+  char *pt = Digits(end, u);
+  char *point;
+  uint32_t i;
+  if(decimals > FMT_MAXDECIMALS){
+    decimals = FMT_MAXDECIMALS;
+  }
+  while((uint32_t)(end - pt) <= decimals){
+    pt--;
+    *pt = '0';                      // at least one digit before the point
+  }
+  if(negative){
+    pt--;
+    *pt = '-';
+  }
+  if(decimals == 0){
+    return Copy(buf, pt, end);
+  }
+  point = end - decimals;
+  for(i = 0; pt + i < point; i++){
+    buf[i] = pt[i];
+  }
+  buf[i++] = '.';
+  while(point < end){
+    buf[i++] = *point++;
+  }
+  buf[i] = 0;
+  return i;
+}
+
+// ******** Fmt_UFix ************
+// unsigned fixed point n/10^decimals with a digit before the point,
+// e.g. (5, 2) gives 0.05
+// Inputs: buffer, number, digits after the point (0 to 9)
+// Outputs: length
+uint32_t Fmt_UFix(char *buf, uint32_t n, uint32_t decimals){
+  return Fix(buf, n, 0, decimals);
+}
+
+// ******** Fmt_Fix ************
+// signed fixed point n/10^decimals, e.g. (-5, 2) gives -0.05
+// Inputs: buffer, number, digits after the point (0 to 9)
+// Outputs: length
+uint32_t Fmt_Fix(char *buf, int32_t n, uint32_t decimals){
+  return Fix(buf, (n < 0) ? -(uint32_t)n : (uint32_t)n, n < 0, decimals);
+}
+
+// ******** Fmt_Pad ************
+// right align formatted text in a field, in place; text at least as
+// long as the field is left alone
+// Inputs: buffer (width+1 characters), its length, field width, fill
+//         character (' ' or '0'; zeros go after a leading '-')
+// Outputs: new length
+uint32_t Fmt_Pad(char *buf, uint32_t len, uint32_t width, char pad){
+  uint32_t shift, i, start = 0;
+  if(len >= width){
+    return len;
+  }
+  shift = width - len;
+  if((pad == '0') && (buf[0] == '-')){
+    start = 1;                      // -0042, not 00-42
+  }
+  for(i = len+1; i > start; i--){   // move the text and its NUL right
+    buf[i-1+shift] = buf[i-1];
+  }
+  for(i = start; i < start+shift; i++){
+    buf[i] = pad;
+  }
+  return width;
+}
@@ -0,0 +1,56 @@
+// Format.h
+// Runs on TM4C123 or the QEMU mps2-an386 machine
+// Integer and fixed-point to text without recursion or division.
+// Each function writes a NULL-terminated string into the caller's
+// buffer and returns its length, so the result goes to any output
+// (LCD_OutString, LCD_DrawString, BSP_OutString) in one call.
+
+#ifndef __FORMAT_H__
+#define __FORMAT_H__
+
+#include <stdint.h>
+
+#define FMT_BUFSIZE      24  // enough for any result below, NULL included
+#define FMT_MAXDECIMALS  9
+
+// ******** Fmt_UDec ************
+// unsigned decimal, 1 to 10 digits
+// Inputs: buffer, number
+// Outputs: length
+uint32_t Fmt_UDec(char *buf, uint32_t n);
+
+// ******** Fmt_Dec ************
+// signed decimal, '-' and 1 to 10 digits
+// Inputs: buffer, number
+// Outputs: length
+uint32_t Fmt_Dec(char *buf, int32_t n);
+
+// ******** Fmt_UHex ************
+// unsigned hexadecimal, 1 to 8 digits, capitals
+// Inputs: buffer, number
+// Outputs: length
+uint32_t Fmt_UHex(char *buf, uint32_t n);
+
+// ******** Fmt_UFix ************
+// unsigned fixed point n/10^decimals with a digit before the point,
+// e.g. (5, 2) gives 0.05
+// Inputs: buffer, number, digits after the point (0 to 9)
+// Outputs: length
+uint32_t Fmt_UFix(char *buf, uint32_t n, uint32_t decimals);
+
+// ******** Fmt_Fix ************
+// signed fixed point n/10^decimals, e.g. (-5, 2) gives -0.05
+// Inputs: buffer, number, digits after the point (0 to 9)
+// Outputs: length
+uint32_t Fmt_Fix(char *buf, int32_t n, uint32_t decimals);
+
+// ******** Fmt_Pad ************
+// right align formatted text in a field, in place; text at least as
+// long as the field is left alone
+// e.g. Fmt_Pad(buf, Fmt_UHex(buf, n), 4, '0') gives 4 hex digits
+// Inputs: buffer (width+1 characters), its length, field width, fill
+//         character (' ' or '0'; zeros go after a leading '-')
+// Outputs: new length
+uint32_t Fmt_Pad(char *buf, uint32_t len, uint32_t width, char pad);
+
+#endif
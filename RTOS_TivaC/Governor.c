@@ -0,0 +1,151 @@
+// Governor.c
+// Runs on TM4C123
+// Load-driven bus clock, see Governor.h.
+// The load of a window is measured in bus cycles at one clock, the
+// clock only changes between windows, so a step never mixes two.
+// Predicting the load at a slower clock assumes the busy cycles stay
+// the same; flash wait states above 40 MHz make them a little fewer
+// at the slower clock, so the prediction errs on the busy side.
+
+#include <stdint.h>
+#include "Governor.h"
+#include "BSP.h"
+#include "os.h"
+#include "PLL.h"
+
+// the clocks, fastest first; integer MHz, so cycles per us are exact
+static const uint8_t Dividers[] = {
+  Bus80MHz, Bus50MHz, Bus40MHz, Bus25MHz, Bus20MHz,
+  Bus16MHz, Bus10MHz, Bus8MHz, Bus5_000MHz, Bus4MHz
+};
+#define LEVELS (sizeof(Dividers)/sizeof(Dividers[0]))
+
+struct task{
+  volatile uint32_t *wcet;     // worst-case bus cycles per run
+  uint32_t rate;               // runs per second
+};
+static struct task Tasks[GOVERNOR_TASKS];
+static uint32_t NumTasks = 0;
+
+static uint32_t Level;         // of the clock in use
+static uint32_t Calm;          // windows in a row that could go slower
+static uint32_t WindowStart;   // BSP_Cycles when the window started
+static uint32_t WindowIdle;    // OS_IdleCycles then
+
+volatile uint32_t Governor_Load;
+volatile uint32_t Governor_Steps;
+
+// bus clock in Hz at a level of the table
+static uint32_t Clock(uint32_t level){
+  return 400000000/(Dividers[level] + 1);
+}
+
+// ******** Governor_AddTask ************
+// have a periodic task's deadlines kept: it must fit at every clock
+// chosen; call before OS_Launch
+// Inputs: the task's worst-case run time in bus cycles, which it keeps
+//         up to date (Motor_ComputeMax, for one), runs per second
+// Outputs: 1 if added, 0 if GOVERNOR_TASKS are already added
+int Governor_AddTask(volatile uint32_t *wcet, uint32_t rate){
+  if(NumTasks >= GOVERNOR_TASKS){
+    return 0;
+  }
+  Tasks[NumTasks].wcet = wcet;
+  Tasks[NumTasks].rate = rate;
+  NumTasks++;
+  return 1;
+}
+
+// ******** Governor_Floor ************
+// slowest bus clock the registered periodic tasks allow, the one at
+// which they take GOVERNOR_RTBOUND % of the time
+// Inputs: none
+// Outputs: clock in Hz
+uint32_t Governor_Floor(void){
+  uint64_t demand = 0;         // bus cycles per second
+  uint32_t i;
+  for(i = 0; i < NumTasks; i++){
+    demand = demand + (uint64_t)(*Tasks[i].wcet)*Tasks[i].rate;
+  }
+  demand = demand*100/GOVERNOR_RTBOUND;
+  return (demand > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)demand;
+}
+
+// ******** Governor_Start ************
+// start from the clock in use, or the next faster one in the table;
+// the first window starts now
+// Inputs: none
+// Outputs: none
+void Governor_Start(void){
+  uint32_t level = LEVELS - 1;
+  while((level > 0) && (Clock(level) < PLL_BusClock())){
+    level--;
+  }
+  if(Clock(level) != PLL_BusClock()){
+    PLL_SetFrequency(Dividers[level]);
+  }
+  Level = level;
+  Calm = 0;
+  WindowStart = BSP_Cycles();
+  WindowIdle = OS_IdleCycles();
+}
+
+// ******** Governor_Sample ************
+// one governor step, what Governor_Thread runs every window: the load
+// since the previous step (or Governor_Start), then at most one clock
+// change; for callers without the kernel
+// Inputs: none
+// Outputs: none
+void Governor_Sample(void){
+  uint32_t next, now, total, idle, span, busy, floor;
+  now = BSP_Cycles();
+  total = OS_IdleCycles();
+  span = now - WindowStart;     // at least the window, often more
+  idle = total - WindowIdle;
+  WindowStart = now;
+  WindowIdle = total;
+  if(span == 0){
+    return;
+  }
+  busy = (idle < span) ? span - idle : 0;
+  Governor_Load = (uint32_t)((uint64_t)busy*100/span);
+  floor = Governor_Floor();
+  next = Level;
+  if((Governor_Load > GOVERNOR_UP) && (next > 0)){
+    next--;                     // busy: one step faster
+  }
+  while((next > 0) && (Clock(next) < floor)){
+    next--;                     // deadlines first, straight there
+  }
+  if((next == Level) && (Level + 1 < LEVELS) &&
+     (Clock(Level + 1) >= floor) &&
+     ((uint64_t)Governor_Load*Clock(Level) <=
+      (uint64_t)GOVERNOR_DOWN*Clock(Level + 1))){
+    Calm++;                     // would keep up one step slower
+    if(Calm >= GOVERNOR_HOLD){
+      next = Level + 1;
+    }
+  } else{
+    Calm = 0;
+  }
+  if(next != Level){
+    Calm = 0;
+    if(PLL_SetFrequency(Dividers[next])){
+      Level = next;
+      Governor_Steps++;
+    }
+  }
+}
+
+// ******** Governor_Thread ************
+// foreground thread, add it with OS_AddThread; Governor_Start, then
+// Governor_Sample every GOVERNOR_WINDOW_MS
+// Inputs: none
+// Outputs: none (never returns)
+void Governor_Thread(void){
+  Governor_Start();
+  for(;;){
+    OS_Sleep(GOVERNOR_WINDOW_MS);
+    Governor_Sample();
+  }
+}
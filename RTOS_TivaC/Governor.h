@@ -0,0 +1,71 @@
+// Governor.h
+// Runs on TM4C123
+// Load-driven bus clock.  Governor_Thread measures the load, the share
+// of each GOVERNOR_WINDOW_MS the kernel did not spend in its idle
+// thread (OS_IdleCycles), and moves PLL_SetFrequency one step through
+// a table of clocks (80 MHz down to 4 MHz):
+//   faster, at once, when the load is over GOVERNOR_UP percent
+//   slower after GOVERNOR_HOLD windows in a row in which the load,
+//     scaled to the slower clock, would still be at most GOVERNOR_DOWN
+// The gap between the two is the hysteresis, so a steady load settles
+// on one clock instead of bouncing between two.
+// Interrupt handlers that preempt the idle thread count as idle, so
+// periodic tasks are guarded separately: each registers its worst-case
+// cycles per run and its rate, and the clock never goes below the one
+// at which they all fit in GOVERNOR_RTBOUND percent of it (the rate
+// monotonic bound), stepping straight up to it if their cost grows.
+// The governor is optional: without the thread the clock stays at the
+// one BSP_Init set.  LaunchPad only, QEMU has no PLL.
+
+#ifndef __GOVERNOR_H__
+#define __GOVERNOR_H__
+
+#include <stdint.h>
+
+#define GOVERNOR_WINDOW_MS 100  // load measured over this, in ms
+#define GOVERNOR_UP        85   // load %, above it one step faster
+#define GOVERNOR_DOWN      60   // load % at the slower clock, at most
+#define GOVERNOR_HOLD      3    // windows in a row before a step down
+#define GOVERNOR_RTBOUND   69   // % of the clock for periodic tasks
+#define GOVERNOR_TASKS     4    // periodic tasks, at most
+
+extern volatile uint32_t Governor_Load;    // % busy, last window
+extern volatile uint32_t Governor_Steps;   // clock changes made
+
+// ******** Governor_AddTask ************
+// have a periodic task's deadlines kept: it must fit at every clock
+// chosen; call before OS_Launch
+// Inputs: the task's worst-case run time in bus cycles, which it keeps
+//         up to date (Motor_ComputeMax, for one), runs per second
+// Outputs: 1 if added, 0 if GOVERNOR_TASKS are already added
+int Governor_AddTask(volatile uint32_t *wcet, uint32_t rate);
+
+// ******** Governor_Thread ************
+// foreground thread, add it with OS_AddThread; Governor_Start, then
+// Governor_Sample every GOVERNOR_WINDOW_MS
+// Inputs: none
+// Outputs: none (never returns)
+void Governor_Thread(void);
+
+// ******** Governor_Start ************
+// start from the clock in use, or the next faster one in the table;
+// the first window starts now
+// Inputs: none
+// Outputs: none
+void Governor_Start(void);
+
+// ******** Governor_Sample ************
+// one governor step, what Governor_Thread runs every window: the load
+// since the previous step (or Governor_Start), then at most one clock
+// change; for callers without the kernel
+// Inputs: none
+// Outputs: none
+void Governor_Sample(void);
+
+// ******** Governor_Floor ************
+// slowest bus clock the registered periodic tasks allow
+// Inputs: none
+// Outputs: clock in Hz
+uint32_t Governor_Floor(void);
+
+#endif
@@ -1,211 +1,443 @@
-/* Adapted from Professor Mazidi's code at microdigitaled.com
- *   cited at EduBase-V2 trainer website
- *
- * Serial LCD Driver Functions
- *
- * The LCD controller of Wytec EduPad board is connected to
- * a shift register on SSI2 of Tiva LaunchPad.  PORTC 6 is used
- * for chip select of the shift register.
- *
- * The connections between the shift register and LCD are
- * Bit 0 - RS (register select)
- * Bit 1 - E (enable)
- * Bit 2 -
- * Bit 4 - Data 4
- * Bit 5 - Data 5
- * Bit 6 - Data 6
- * Bit 7 - Data 7
- *
- * Built and tested with Keil MDK-ARM v5.24a and TM4C_DFP v1.1.0
- */
-
-#include <stdint.h>
-#include "Timer0A.h"
-#include "SSI2.h"
-#include "LCD.h"
-#include "tm4c123gh6pm.h"
-
-void DisableInterrupts(void);    // Disable interrupts
-void EnableInterrupts(void);     // Enable interrupts
-uint32_t StartCritical (void);   // previous I bit, disable interrupts
-void EndCritical( uint32_t sr ); // restore I bit to previous value
-void WaitForInterrupt(void);     // low power mode
-
-// Macros
-#define RS 1    // BIT0 mask for reg select
-#define EN 2    // BIT1 mask for E
-
-/**************** Private Functions ****************/
-
-// LCD's SPI chip select is at PC6 (mask of 0x40 for SSI2_Write)
-void LCD_nibble_write( uint8_t data, uint8_t control) {
-  data &= 0xF0;       // clear lower nibble for control
-  control &= 0x0F;    // clear upper nibble for data
-  SSI2_write( (data | control), 0x40 );       // RS = 0, R/W = 0
-  SSI2_write( (data | control | EN), 0x40 );  // pulse E
-  //delayMs(0);
-  SSI2_write( data, 0x40 );
-  return;
-}
-
-/**************** Public Functions ****************/
-
-// Clear the LCD
-// Inputs: none
-// Outputs: none
-void LCD_Clear(void) {
-  LCD_command(0x01);  // Clear Display
-  // not necessary //LCD_command(0x80);  // Move cursor back to 1st position
-}
-
-// initialize SSI2 CS for LCD, then initialize LCD controller
-// assumes Timer1A and SSI2 have already been initialized
-void LCD_init(void) {
-  SYSCTL_RCGCGPIO_R |= 0x04;   // enable clock to GPIOC
-
-  // PORTC 6 for SSI2 chip select
-  GPIO_PORTC_AMSEL_R &= ~0x40;      // disable analog
-  GPIO_PORTC_DATA_R |= 0x40;        // set PORTC6 idle high
-  GPIO_PORTC_DIR_R |= 0x40;         // set PORTC6 as output for CS
-  GPIO_PORTC_DEN_R |= 0x40;         // set PORTC6 as digital pins
-
-  Timer0A_Wait1ms(20);        // LCD controller reset sequence
-  LCD_nibble_write(0x30, 0);
-  Timer0A_Wait1ms(5);
-  LCD_nibble_write(0x30, 0);
-  Timer0A_Wait1ms(1);
-  LCD_nibble_write(0x30, 0);
-  Timer0A_Wait1ms(1);
-
-  LCD_nibble_write(0x20, 0);  // use 4-bit data mode
-  Timer0A_Wait1ms(1);
-  LCD_command(0x28);          // set 4-bit data, 2-line, 5x7 font
-  LCD_command(0x06);          // move cursor right
-  LCD_command(0x01);          // clear screen, move cursor to home
-  LCD_command(0x0F);          // turn on display, cursor blinking
-
-  return;
-}
-
-// send a command to the LCD
-void LCD_command( uint8_t command ) {
-  uint32_t intStatus = StartCritical();
-  LCD_nibble_write(command & 0xF0, 0);    // upper nibble first
-  LCD_nibble_write(command << 4, 0);      // then lower nibble
-  EndCritical( intStatus );
-
-  if (command < 4)
-    Timer0A_Wait1ms(2);         // command 1 and 2 needs up to 1.64ms
-  else
-    Timer0A_Wait1ms(1);         // all others 40 us
-
-  return;
-}
-
-// send data (a character) to the LCD
-void LCD_data( uint8_t data ) {
-  uint32_t intStatus = StartCritical();
-  LCD_nibble_write(data & 0xF0, RS);      // upper nibble first
-  LCD_nibble_write(data << 4, RS);        // then lower nibble
-  EndCritical( intStatus );
-
-  Timer0A_Wait1ms(1);
-
-  return;
-}
-
-//------------LCD_OutString------------
-// Output String (NULL termination)
-// Input: pointer to a NULL-terminated string to be transferred
-// Output: none
-void LCD_OutString( uint8_t *ptr ) {
-
-  // adpated from https://github.com/grantguglielmo/EE-445L/blob/1506575299a3973a2f23aa0fa90bbaaa7fdf8e0a/ValvanoWareTM4C123/ValvanoWareTM4C123/LCD_4C123/lcd.c#L137-L146
-
-  // *ptr is a pointer to an array of chars to print, so iterate through
-   while(*ptr) {
-    LCD_data(*ptr);
-    ptr++;
-  }
-
-  return;
-}
-
-//-----------------------LCD_OutUDec-----------------------
-// Output a 32-bit number in unsigned decimal format
-// Input: 32-bit number to be transferred
-// Output: none
-// Variable format 1-10 digits with no space before or after
-void LCD_OutUDec( uint32_t n ) {
-  // This function uses recursion to convert decimal number
-  //   of unspecified length as an ASCII string
-
-    // adapted from https://github.com/grantguglielmo/EE-445L/blob/1506575299a3973a2f23aa0fa90bbaaa7fdf8e0a/ValvanoWareTM4C123/ValvanoWareTM4C123/LCD_4C123/lcd.c#L137-L146
-
-  if(n >= 10) {
-    LCD_OutUDec(n/10);
-    n = n%10;
-  }
-
-  LCD_data(n+'0');  // n is between 0 and 9
-
-  return;
-}
-
-//-----------------------LCD_OutUHex-----------------------
-// Output a 32-bit number in unsigned hexadecimal format
-// Input: 32-bit number to be transferred
-// Output: none
-// Variable format 1 to 8 digits with no space before or after
-void LCD_OutUHex( uint32_t number ) {
-// This function uses recursion to convert the number of
-//   unspecified length as an ASCII string
-
-    // adapted from https://github.com/grantguglielmo/EE-445L/blob/1506575299a3973a2f23aa0fa90bbaaa7fdf8e0a/ValvanoWareTM4C123/ValvanoWareTM4C123/LCD_4C123/lcd.c#L137-L146 but used decimal 16 instead of hex equivalent, should still work.
-
-  if(number >= 16) {
-    LCD_OutUHex(number/16);
-    number = number%16;
-  }
-
-  if(number < 10) {
-    LCD_data(number+'0');
-  } else {
-    LCD_data((number-10)+'A');
-  }
-
-  return;
-}
-
-// -----------------------LCD_OutUFix----------------------
-// Output characters to LCD display in fixed-point format
-// unsigned decimal, resolution 0.1, range 000.0 to 999.9
-// Inputs:  an unsigned 32-bit number
-// Outputs: none
-// E.g., 0,    then output "0.0"
-//       3,    then output "0.3"
-//       89,   then output "8.9"
-//       123,  then output "12.3"
-//       9999, then output "999.9"
-//     > 9999, then output "*.***"
-void LCD_OutUFix( uint32_t number ) {
-
-  if(number > 9999) {
-
-    // values greater than 9999
-    LCD_OutString("*.***");
-
-  } else {
-
-    // Take number and divide by 10 to get whole value
-    LCD_OutUDec(number/10);
-
-    LCD_data('.');
-
-    // get modulo of number for fractional value and place after decimal
-    LCD_OutUDec(number%10);
-
-  }
-
-  return;
-}
+/* Adapted from Professor Mazidi's code at microdigitaled.com
+ *   cited at EduBase-V2 trainer website
+ *
+ * Serial LCD Driver Functions
+ *
+ * The LCD controller of Wytec EduPad board is connected to
+ * a shift register on SSI2 of Tiva LaunchPad.  PORTC 6 is used
+ * for chip select of the shift register.
+ *
+ * The connections between the shift register and LCD are
+ * Bit 0 - RS (register select)
+ * Bit 1 - E (enable)
+ * Bit 2 -
+ * Bit 4 - Data 4
+ * Bit 5 - Data 5
+ * Bit 6 - Data 6
+ * Bit 7 - Data 7
+ *
+ * Built and tested with Keil MDK-ARM v5.24a and TM4C_DFP v1.1.0
+ *
+ * Commands and characters go into a queue and the caller returns right
+ * away.  A state machine drains it in the background: it starts the
+ * SSI2 transaction for one write, and when that is latched it arms
+ * Timer4A (one-shot, IRQ 70) for the HD44780 execution time; the
+ * Timer4A interrupt then starts the next write.  Only the power-on
+ * reset in LCD_init waits, on the Timer0A delay service.
+ *
+ * The LCD_Draw functions write a 2x16 shadow of the screen instead;
+ * LCD_Refresh compares it with what the LCD shows and queues only the
+ * cells that changed, with one cursor move per run of them.
+ */
+
+#include <stdint.h>
+#include "Timer.h"
+#include "Timer0A.h"
+#include "PLL.h"
+#include "SSI2.h"
+#include "Clock.h"
+#include "LCD.h"
+#include "Format.h"
+#include "os.h"
+#include "tm4c123gh6pm.h"
+
+void DisableInterrupts(void);    // Disable interrupts
+void EnableInterrupts(void);     // Enable interrupts
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+void WaitForInterrupt(void);     // low power mode
+
+// Macros
+#define RS 1    // BIT0 mask for reg select
+#define EN 2    // BIT1 mask for E
+
+#define LCD_PRI       5         // Timer4A priority, below SSI2
+#define LCD_CMD_US    50        // execution time, 37 us (41 us for data)
+#define LCD_CLEAR_US  2000      // clear and return home, 1.52 ms
+#define LCD_RETRY_US  20        // SSI2 was busy with another transaction
+
+// queue entries: the byte in bits 7-0, RS in bit 8, long command in bit 9
+#define Q_RS          0x100
+#define Q_SLOW        0x200
+
+static uint16_t Queue[LCD_QUEUESIZE];
+static volatile uint32_t PutI;  // next entry to fill
+static volatile uint32_t GetI;  // next entry to send
+static volatile uint8_t Running;// a write is going out or executing
+static uint16_t Current;        // the write going out
+static uint8_t Frame[6];        // its SSI2 bytes, in use until it is latched
+static uint32_t BusHz;          // bus clock the waits scale to, from LCD_init
+
+volatile uint32_t LCD_MaxDepth; // most writes ever waiting
+volatile uint32_t LCD_Dropped;  // writes lost because the queue was full
+
+#define NOCURSOR      0xFF      // DDRAM address unknown
+static char Shadow[LCD_ROWS][LCD_COLS]; // what the application drew
+static char Shown[LCD_ROWS][LCD_COLS];  // what the LCD has been sent
+static uint8_t Cursor;          // DDRAM address of the next data write
+static uint8_t DrawRow, DrawCol;// next LCD_DrawChar cell
+
+/**************** Private Functions ****************/
+
+// LCD's SPI chip select is at PC6 (mask of 0x40 for SSI2_Write)
+// builds the three latches of one nibble: set up, E high, E low
+static void LCD_nibble( uint8_t *frame, uint8_t data, uint8_t control) {
+  data &= 0xF0;       // clear lower nibble for control
+  control &= 0x0F;    // clear upper nibble for data
+  frame[0] = data | control;       // RS = 0, R/W = 0
+  frame[1] = data | control | EN;  // pulse E
+  frame[2] = data | control;       // RS and data held while E falls
+}
+
+void LCD_nibble_write( uint8_t data, uint8_t control) {
+  uint8_t frame[3];
+  LCD_nibble(frame, data, control);
+  SSI2_Transfer(frame, 3, 0x40, SSI2_LATCH_EACH);
+  return;
+}
+
+// new bus clock, called by PLL_SetFrequency; the Timer driver rescales
+// the wait in progress
+static void Retime(uint32_t from, uint32_t to){
+  BusHz = to;
+}
+
+// one-shot Timer4A interrupt after us microseconds
+static void Arm(uint32_t us){
+  Timer_Start(TIMER_4, (uint32_t)((uint64_t)us*BusHz/1000000));
+}
+
+static void Sent(void);
+
+// start the oldest queued write, both nibbles as one SSI2 transaction;
+// called with interrupts disabled or from the Timer4A interrupt
+static void Next(void){
+  uint8_t data, control;
+  if(GetI == PutI){
+    Running = 0;                // queue empty, stop until LCD_Enqueue
+    return;
+  }
+  Running = 1;
+  Current = Queue[GetI%LCD_QUEUESIZE];
+  data = Current & 0xFF;
+  control = (Current & Q_RS) ? RS : 0;
+  LCD_nibble(&Frame[0], data & 0xF0, control);  // upper nibble first
+  LCD_nibble(&Frame[3], data << 4, control);    // then lower nibble
+  if(SSI2_Start(Frame, 6, 0x40, SSI2_LATCH_EACH, &Sent)){
+    GetI++;
+  } else{
+    Arm(LCD_RETRY_US);          // try again after the other transaction
+  }
+}
+
+// SSI2 latched the last nibble, the HD44780 is executing it now
+static void Sent(void){
+  Arm((Current & Q_SLOW) ? LCD_CLEAR_US : LCD_CMD_US);
+}
+
+// Timer4A timeout, acknowledged by the Timer driver
+static void Timeout(uint32_t timer, uint32_t status){
+  Next();
+}
+
+// add one write to the queue; called with interrupts disabled
+static void Put( uint16_t entry ) {
+  uint32_t depth = PutI - GetI;
+  if(depth >= LCD_QUEUESIZE){
+    LCD_Dropped++;
+    return;
+  }
+  Queue[PutI%LCD_QUEUESIZE] = entry;
+  PutI++;
+  if(depth+1 > LCD_MaxDepth){
+    LCD_MaxDepth = depth+1;
+  }
+}
+
+// add one write to the queue, start the state machine if it is idle
+static void LCD_Enqueue( uint16_t entry ) {
+  uint32_t sr = StartCritical();
+  Put(entry);
+  if(!Running){
+    Next();
+  }
+  EndCritical(sr);
+}
+
+// a whole string in one batch: one critical section, one start
+static void LCD_EnqueueString( const uint8_t *pt ) {
+  uint32_t sr = StartCritical();
+  while(*pt){
+    Put(*pt | Q_RS);
+    pt++;
+  }
+  if(!Running){
+    Next();
+  }
+  EndCritical(sr);
+}
+
+/**************** Public Functions ****************/
+
+// Clear the LCD
+// Inputs: none
+// Outputs: none
+void LCD_Clear(void) {
+  uint32_t r, c;
+  LCD_command(0x01);  // Clear Display
+  // not necessary //LCD_command(0x80);  // Move cursor back to 1st position
+  for(r = 0; r < LCD_ROWS; r++) {   // the screen is known again
+    for(c = 0; c < LCD_COLS; c++) {
+      Shown[r][c] = ' ';
+    }
+  }
+  Cursor = 0;
+}
+
+// initialize SSI2 CS for LCD, then initialize LCD controller
+// assumes Timer0A has already been initialized; SSI2 is brought up
+// here if no one has yet
+void LCD_init(void) {
+  SSI2_init();
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTC);
+
+  // PORTC 6 for SSI2 chip select
+  GPIO_PORTC_AMSEL_R &= ~0x40;      // disable analog
+  GPIO_PORTC_DATA_R |= 0x40;        // set PORTC6 idle high
+  GPIO_PORTC_DIR_R |= 0x40;         // set PORTC6 as output for CS
+  GPIO_PORTC_DEN_R |= 0x40;         // set PORTC6 as digital pins
+
+  BusHz = PLL_BusClock();
+  PLL_Register(&Retime);
+  Timer_Open(TIMER_4, "LCD");  // paces the queue
+  Timer_OneShot(TIMER_4, LCD_PRI, &Timeout);
+  PutI = GetI = 0;
+  Running = 0;
+  LCD_MaxDepth = 0;
+  LCD_Dropped = 0;
+
+  Timer0A_Wait1ms(20);        // LCD controller reset sequence, 15 ms after power-on
+  LCD_nibble_write(0x30, 0);
+  Timer0A_WaitUs(4200);       // more than 4.1 ms
+  LCD_nibble_write(0x30, 0);
+  Timer0A_WaitUs(150);        // more than 100 us
+  LCD_nibble_write(0x30, 0);
+  Timer0A_WaitUs(50);         // 37 us from here on
+
+  LCD_nibble_write(0x20, 0);  // use 4-bit data mode
+  Timer0A_WaitUs(50);
+  LCD_command(0x28);          // set 4-bit data, 2-line, 5x7 font; queued from here on
+  LCD_command(0x06);          // move cursor right
+  LCD_Clear();                // clear screen, move cursor to home
+  LCD_command(0x0F);          // turn on display, cursor blinking
+  LCD_DrawClear();
+
+  return;
+}
+
+// send a command to the LCD
+void LCD_command( uint8_t command ) {
+  if (command < 4)
+    LCD_Enqueue(command | Q_SLOW);  // command 1 and 2 needs up to 1.64ms
+  else
+    LCD_Enqueue(command);           // all others 40 us
+
+  return;
+}
+
+// send data (a character) to the LCD
+void LCD_data( uint8_t data ) {
+  LCD_Enqueue(data | Q_RS);
+
+  return;
+}
+
+// writes waiting in the queue
+uint32_t LCD_QueueDepth(void) {
+  return PutI - GetI;
+}
+
+// 1 until every queued write has gone out and executed
+int LCD_Busy(void) {
+  return Running;
+}
+
+// wait until the queue has drained
+void LCD_Flush(void) {
+  uint32_t sr;
+  if(OS_Running()) {
+    while(Running) {
+      OS_Suspend();             // other threads run meanwhile
+    }
+    return;
+  }
+  sr = StartCritical();
+  while(Running) {
+    WaitForInterrupt();         // wakes on the pending interrupt
+    EndCritical(sr);            // let it run
+    sr = StartCritical();
+  }
+  EndCritical(sr);
+}
+
+//------------LCD_OutString------------
+// Output String (NULL termination)
+// Input: pointer to a NULL-terminated string to be transferred
+// Output: none
+void LCD_OutString( uint8_t *ptr ) {
+  LCD_EnqueueString(ptr);     // queued as one batch
+
+  return;
+}
+
+//-----------------------LCD_OutUDec-----------------------
+// Output a 32-bit number in unsigned decimal format
+// Input: 32-bit number to be transferred
+// Output: none
+// Variable format 1-10 digits with no space before or after
+void LCD_OutUDec( uint32_t n ) {
+  char buf[FMT_BUFSIZE];
+  Fmt_UDec(buf, n);
+  LCD_OutString((uint8_t *)buf);
+
+  return;
+}
+
+//-----------------------LCD_OutUHex-----------------------
+// Output a 32-bit number in unsigned hexadecimal format
+// Input: 32-bit number to be transferred
+// Output: none
+// Variable format 1 to 8 digits with no space before or after
+void LCD_OutUHex( uint32_t number ) {
+  char buf[FMT_BUFSIZE];
+  Fmt_UHex(buf, number);
+  LCD_OutString((uint8_t *)buf);
+
+  return;
+}
+
+// -----------------------LCD_OutUFix----------------------
+// Output characters to LCD display in fixed-point format
+// unsigned decimal, resolution 0.1, range 000.0 to 999.9
+// Inputs:  an unsigned 32-bit number
+// Outputs: none
+// E.g., 0,    then output "0.0"
+//       3,    then output "0.3"
+//       89,   then output "8.9"
+//       123,  then output "12.3"
+//       9999, then output "999.9"
+//     > 9999, then output "*.***"
+void LCD_OutUFix( uint32_t number ) {
+  char buf[FMT_BUFSIZE];
+
+  if(number > 9999) {
+
+    // values greater than 9999
+    LCD_OutString((uint8_t *)"*.***");
+
+  } else {
+
+    Fmt_UFix(buf, number, 1);
+    LCD_OutString((uint8_t *)buf);
+
+  }
+
+  return;
+}
+
+/**************** Shadow Framebuffer ****************/
+
+// move the drawing position
+// Inputs: row 0 or 1, column 0 to 15
+// Outputs: none
+void LCD_Goto( uint32_t row, uint32_t col ) {
+  DrawRow = (row < LCD_ROWS) ? row : LCD_ROWS-1;
+  DrawCol = (col < LCD_COLS) ? col : LCD_COLS;
+}
+
+// draw one character and move right; past column 15 it is clipped
+void LCD_DrawChar( char c ) {
+  if(DrawCol < LCD_COLS) {
+    Shadow[DrawRow][DrawCol] = c;
+    DrawCol++;
+  }
+}
+
+// draw a NULL-terminated string from the drawing position
+void LCD_DrawString( const char *pt ) {
+  while(*pt) {
+    LCD_DrawChar(*pt);
+    pt++;
+  }
+}
+
+// draw an unsigned decimal right aligned in a field of width characters
+// (1 to 10), padded with spaces; all '*' when it doesn't fit
+void LCD_DrawUDec( uint32_t n, uint32_t width ) {
+  char buf[FMT_BUFSIZE];
+  uint32_t len = Fmt_UDec(buf, n);
+  if(width > 10) {
+    width = 10;
+  }
+  if(len > width) {
+    while(width) {
+      LCD_DrawChar('*');
+      width--;
+    }
+    return;
+  }
+  Fmt_Pad(buf, len, width, ' ');
+  LCD_DrawString(buf);
+}
+
+// fill the shadow with spaces and go to row 0, column 0
+void LCD_DrawClear(void) {
+  uint32_t r, c;
+  for(r = 0; r < LCD_ROWS; r++) {
+    for(c = 0; c < LCD_COLS; c++) {
+      Shadow[r][c] = ' ';
+    }
+  }
+  DrawRow = DrawCol = 0;
+}
+
+// forget what the LCD shows, so the next LCD_Refresh sends every cell;
+// use it after writing the LCD with LCD_command or LCD_data
+void LCD_Invalidate(void) {
+  uint32_t r, c;
+  for(r = 0; r < LCD_ROWS; r++) {
+    for(c = 0; c < LCD_COLS; c++) {
+      Shown[r][c] = 0;              // never drawn
+    }
+  }
+  Cursor = NOCURSOR;
+}
+
+// queue the cells that differ from what the LCD shows; a cursor move
+// only where a run of changed cells doesn't continue from the last one.
+// Stops early rather than overflow the queue.
+// Inputs: none
+// Outputs: number of changed cells still to send (0 when up to date)
+uint32_t LCD_Refresh(void) {
+  uint32_t r, c, left = 0;
+  uint8_t address;
+  for(r = 0; r < LCD_ROWS; r++) {
+    for(c = 0; c < LCD_COLS; c++) {
+      if(Shadow[r][c] == Shown[r][c]) {
+        continue;
+      }
+      if(left || (LCD_QueueDepth() > LCD_QUEUESIZE-2)) {
+        left++;                     // the next refresh sends it
+        continue;
+      }
+      address = r*0x40 + c;         // row 1 starts at 0x40
+      if(address != Cursor) {
+        LCD_command(0x80 | address);// set DDRAM address
+      }
+      LCD_data(Shadow[r][c]);
+      Shown[r][c] = Shadow[r][c];
+      Cursor = address+1;
+    }
+  }
+  return left;
+}
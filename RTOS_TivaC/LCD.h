@@ -1,67 +1,124 @@
-/* Adapted from Professor Mazidi's code at microdigitaled.com
- *   cited at EduBase-V2 trainer website
- *
- * Serial LCD Driver Functions
- *
- * The LCD controller of Wytec EduPad board is connected to
- * a shift register on SSI2 of Tiva LaunchPad.  PORTC 6 is used
- * for chip select of the shift register.
- *
- * The connections between the shift register and LCD are
- * Bit 0 - RS (register select)
- * Bit 1 - E (enable)
- * Bit 2 -
- * Bit 4 - Data 4
- * Bit 5 - Data 5
- * Bit 6 - Data 6
- * Bit 7 - Data 7
- *
- * Built and tested with Keil MDK-ARM v5.24a and TM4C_DFP v1.1.0
- */
-
-#ifndef __LCD_H__
-#define __LCD_H__
-
-// Clear the LCD
-// Inputs: none
-// Outputs: none
-void LCD_Clear();
-
-// initialize SSI2 CS for LCD, then initialize LCD controller
-// assumes Timer0A and SSI2 have already been initialized
-void LCD_init(void);
-
-// send a command to the LCD
-void LCD_command( uint8_t command );
-
-// send data (a character) to the LCD
-void LCD_data( uint8_t data );
-
-//------------LCD_OutString------------
-// Output String (NULL termination)
-// Input: pointer to a NULL-terminated string to be transferred
-// Output: none
-void LCD_OutString( uint8_t *ptr );
-
-//-----------------------LCD_OutUDec-----------------------
-// Output a 32-bit number in unsigned decimal format
-// Input: 32-bit number to be transferred
-// Output: none
-// Variable format 1-10 digits with no space before or after
-void LCD_OutUDec( uint32_t n );
-
-//-----------------------LCD_OutUHex-----------------------
-// Output a 32-bit number in unsigned hexadecimal format
-// Input: 32-bit number to be transferred
-// Output: none
-// Variable format 1 to 8 digits with no space before or after
-void LCD_OutUHex( uint32_t number );
-
-// -----------------------LCD_OutUFix----------------------
-// Output characters to LCD display in fixed-point format
-// unsigned decimal, resolution 0.1, range 000.0 to 999.9
-// Inputs:  an unsigned 32-bit number
-// Outputs: none
-void LCD_OutUFix( uint32_t number );
-
-#endif
+/* Adapted from Professor Mazidi's code at microdigitaled.com
+ *   cited at EduBase-V2 trainer website
+ *
+ * Serial LCD Driver Functions
+ *
+ * The LCD controller of Wytec EduPad board is connected to
+ * a shift register on SSI2 of Tiva LaunchPad.  PORTC 6 is used
+ * for chip select of the shift register.
+ *
+ * The connections between the shift register and LCD are
+ * Bit 0 - RS (register select)
+ * Bit 1 - E (enable)
+ * Bit 2 -
+ * Bit 4 - Data 4
+ * Bit 5 - Data 5
+ * Bit 6 - Data 6
+ * Bit 7 - Data 7
+ *
+ * Built and tested with Keil MDK-ARM v5.24a and TM4C_DFP v1.1.0
+ */
+
+#ifndef __LCD_H__
+#define __LCD_H__
+
+#define LCD_QUEUESIZE 64  // writes that can wait, power of 2
+#define LCD_ROWS      2
+#define LCD_COLS      16
+
+// Clear the LCD
+// Inputs: none
+// Outputs: none
+// also tells LCD_Refresh the screen is blank
+void LCD_Clear();
+
+// initialize SSI2 CS for LCD, then initialize LCD controller
+// assumes Timer0A has already been initialized; SSI2 is brought up
+// here if no one has yet
+void LCD_init(void);
+
+// send a command to the LCD
+// queued; returns right away, dropped if the queue is full
+void LCD_command( uint8_t command );
+
+// send data (a character) to the LCD
+// queued; returns right away, dropped if the queue is full
+void LCD_data( uint8_t data );
+
+// writes waiting in the queue
+uint32_t LCD_QueueDepth(void);
+
+// 1 until every queued write has gone out and executed
+int LCD_Busy(void);
+
+// wait until the queue has drained; a thread lets the others run,
+// otherwise the CPU sleeps between interrupts
+void LCD_Flush(void);
+
+// queue statistics since LCD_init
+extern volatile uint32_t LCD_MaxDepth; // most writes ever waiting
+extern volatile uint32_t LCD_Dropped;  // writes lost because the queue was full
+
+//------------LCD_OutString------------
+// Output String (NULL termination)
+// Input: pointer to a NULL-terminated string to be transferred
+// Output: none
+void LCD_OutString( uint8_t *ptr );
+
+//-----------------------LCD_OutUDec-----------------------
+// Output a 32-bit number in unsigned decimal format
+// Input: 32-bit number to be transferred
+// Output: none
+// Variable format 1-10 digits with no space before or after
+void LCD_OutUDec( uint32_t n );
+
+//-----------------------LCD_OutUHex-----------------------
+// Output a 32-bit number in unsigned hexadecimal format
+// Input: 32-bit number to be transferred
+// Output: none
+// Variable format 1 to 8 digits with no space before or after
+void LCD_OutUHex( uint32_t number );
+
+// -----------------------LCD_OutUFix----------------------
+// Output characters to LCD display in fixed-point format
+// unsigned decimal, resolution 0.1, range 000.0 to 999.9
+// Inputs:  an unsigned 32-bit number
+// Outputs: none
+void LCD_OutUFix( uint32_t number );
+
+//------------Shadow framebuffer------------
+// The application draws into a 2x16 copy of the screen whenever it
+// likes; LCD_Refresh queues only the cells that changed since the last
+// refresh, so the SSI2 and LCD time follow what changed, not how often
+// the screen is redrawn.  LCD_init leaves it blank and in step.
+
+// move the drawing position
+// Inputs: row 0 or 1, column 0 to 15
+// Outputs: none
+void LCD_Goto( uint32_t row, uint32_t col );
+
+// draw one character and move right; past column 15 it is clipped
+void LCD_DrawChar( char c );
+
+// draw a NULL-terminated string from the drawing position
+void LCD_DrawString( const char *pt );
+
+// draw an unsigned decimal right aligned in a field of width characters
+// (1 to 10), padded with spaces; all '*' when it doesn't fit
+void LCD_DrawUDec( uint32_t n, uint32_t width );
+
+// fill the shadow with spaces and go to row 0, column 0
+void LCD_DrawClear(void);
+
+// forget what the LCD shows, so the next LCD_Refresh sends every cell;
+// use it after writing the LCD with LCD_command or LCD_data
+void LCD_Invalidate(void);
+
+// queue the changed cells, with a cursor move only where a run of
+// them doesn't continue from the last one
+// stops early rather than overflow the queue
+// Inputs: none
+// Outputs: number of changed cells still to send (0 when up to date)
+uint32_t LCD_Refresh(void);
+
+#endif
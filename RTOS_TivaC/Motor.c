@@ -0,0 +1,231 @@
+// Motor.c
+// Runs on TM4C123
+// DC motor on an H-bridge, see Motor.h.
+// The PID works in 1/100 RPM and in duty scaled by 2^MOTOR_SHIFT, with
+// 64-bit products.  The derivative acts on the measured speed, so a set
+// speed step doesn't kick the output.  Anti-windup: the integral only
+// grows while the output isn't saturated in the direction of the error,
+// and it never exceeds full duty on its own.  A bridge fault stops the
+// loop integrating until Motor_Restart.
+// Stopped (set speed and duty 0), the motor is a deep sleep client
+// (BSP_DeepClient): the PWM is switched off, both outputs low, and
+// Timer3 stands still, so the control loop pauses; the run after it
+// starts a new schedule rather than record the sleep as jitter.
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "Motor.h"
+#include "BSP.h"
+#include "Clock.h"
+#include "Encoder.h"
+#include "PLL.h"
+#include "PWM.h"
+#include "Timer.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+
+#define MOTOR_GEN   PWM0_GEN2
+#define MOTOR_TIMER TIMER_3
+#define IMAX ((int64_t)MOTOR_FULL<<MOTOR_SHIFT)
+
+static struct Motor_Gains Gains;
+static volatile uint8_t NewGains;
+static volatile uint32_t Target;  // 1/100 RPM
+static int64_t Integral;          // duty << MOTOR_SHIFT
+static int32_t PrevSpeed;
+static uint32_t Period;           // nominal, bus cycles
+static uint32_t Due;              // BSP_Cycles the next run is due at
+static volatile uint32_t Duty;    // last written, 1/65536
+static volatile uint8_t Woke;     // Timer3 stood still in a deep sleep
+volatile uint32_t Motor_Jitter, Motor_JitterMax;
+volatile uint32_t Motor_Compute, Motor_ComputeMax, Motor_Runs;
+
+// MOTOR_DEAD_NS in bus cycles, at least 1
+static uint32_t Dead(uint32_t busFreq){
+  uint32_t dead = (uint32_t)((uint64_t)busFreq*MOTOR_DEAD_NS/1000000000);
+  return dead ? dead : 1;
+}
+
+// new bus clock, called by PLL_SetFrequency with interrupts disabled;
+// the Timer driver keeps the control rate, this keeps the PWM and the
+// jitter measurement, whose next due time moves to new cycles
+static void Retime(uint32_t from, uint32_t to){
+  uint32_t now = BSP_Cycles();
+  PWM_SetClock(MOTOR_GEN, to, Dead(to));
+  if((int32_t)(Due - now) > 0){
+    Due = now + (uint32_t)((uint64_t)(Due - now)*to/from);
+  }
+  Period = to/MOTOR_CTRLFREQ;
+}
+
+// deep sleep client: stopped, the PWM can be off and the loop paused
+// until it wakes; the PWM starts again at the same 0% duty
+static int Park(int sleep){
+  if(sleep == 0){
+    PWM_Open(MOTOR_GEN, PLL_BusClock(), MOTOR_PWMFREQ,
+             Dead(PLL_BusClock()), 1);
+    Woke = 1;
+    return 1;
+  }
+  if((Target != 0) || (Duty != 0)){
+    return 0;
+  }
+  PWM_Stop(MOTOR_GEN);
+  return 1;
+}
+
+// ******** Motor_Init ************
+// set up PE4, PE5, PD2 and the PWM, motor off
+// Inputs: none
+// Outputs: 1 if the PWM started
+int Motor_Init(void){
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTD);
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTE);
+  GPIO_PORTE_AMSEL_R &= ~0x30;
+  GPIO_PORTE_AFSEL_R |= 0x30;           // PE5-4 alternate function
+  GPIO_PORTE_PCTL_R = (GPIO_PORTE_PCTL_R&0xFF00FFFF)|0x00440000; // M0PWM5-4
+  GPIO_PORTE_DEN_R |= 0x30;
+  GPIO_PORTD_DIR_R &= ~0x04;            // PD2 input
+  GPIO_PORTD_AMSEL_R &= ~0x04;
+  GPIO_PORTD_AFSEL_R |= 0x04;
+  GPIO_PORTD_PCTL_R = (GPIO_PORTD_PCTL_R&0xFFFFF0FF)|0x00000400; // M0FAULT0
+  GPIO_PORTD_PDR_R |= 0x04;             // no bridge connected: no fault
+  GPIO_PORTD_DEN_R |= 0x04;
+  PLL_Register(&Retime);
+  Duty = 0;
+  if(!PWM_Open(MOTOR_GEN, PLL_BusClock(), MOTOR_PWMFREQ,
+               Dead(PLL_BusClock()), 1)){
+    return 0;
+  }
+  BSP_DeepClient(CLOCK_TIMER, 1u<<MOTOR_TIMER, &Park);
+  return 1;
+}
+
+// ******** Motor_SetDuty ************
+// drive from the next PWM period on; constant, small cost
+// Inputs: duty 0 to MOTOR_FULL
+// Outputs: none
+void Motor_SetDuty(uint32_t duty){
+  Duty = duty;
+  PWM_SetDuty(MOTOR_GEN, duty);
+}
+
+// ******** Motor_Faulted ************
+// Inputs: none
+// Outputs: 1 while the bridge fault has the outputs off
+int Motor_Faulted(void){
+  return PWM_Faulted(MOTOR_GEN);
+}
+
+// ******** Motor_Restart ************
+// run again after a fault, from 0% duty
+// Inputs: none
+// Outputs: none
+void Motor_Restart(void){
+  Duty = 0;
+  PWM_SetDuty(MOTOR_GEN, 0);
+  PWM_ClearFault(MOTOR_GEN);
+}
+
+// one control period, in the Timer3A interrupt
+static void Control(uint32_t timer, uint32_t status){
+  uint32_t start = BSP_Cycles();
+  uint32_t late, target;
+  int32_t speed, e;
+  int64_t u;
+  if(Woke){                     // paused in a deep sleep: a new
+    Woke = 0;                   // schedule from this run
+    Due = start;
+  }
+  late = start - Due;           // against the schedule, so lateness
+  if((int32_t)late < 0){        // doesn't carry into the next run
+    late = 0 - late;            // early: the schedule drifted, restart it
+    Due = start;
+  } else if(late >= Period){
+    Due = start - late%Period;  // whole periods missed, the slot it ran in
+  }
+  Due = Due + Period;
+  Motor_Jitter = late;
+  if(late > Motor_JitterMax){
+    Motor_JitterMax = late;
+  }
+  if(NewGains){
+    NewGains = 0;
+    Integral = 0;
+  }
+  target = Target;
+  Encoder_Latch();                // this period's edges, for the thread
+  speed = (int32_t)Encoder_Speed(0); // up to the previous period
+  if(target == 0 || PWM_Faulted(MOTOR_GEN)){
+    Integral = 0;                 // stopped or shut down: start over
+    u = 0;
+  } else{
+    e = (int32_t)target - speed;
+    u = (int64_t)Gains.kff*target + ((int64_t)Gains.offset<<MOTOR_SHIFT)
+      + (int64_t)Gains.kp*e - (int64_t)Gains.kd*(speed - PrevSpeed)
+      + Integral;
+    if(!((u >= IMAX) && (e > 0)) && !((u <= 0) && (e < 0))){
+      Integral += (int64_t)Gains.ki*e;
+      if(Integral > IMAX){
+        Integral = IMAX;
+      } else if(Integral < -IMAX){
+        Integral = -IMAX;
+      }
+    }
+    u = u>>MOTOR_SHIFT;
+    if(u < 0){
+      u = 0;
+    } else if(u > MOTOR_FULL){
+      u = MOTOR_FULL;
+    }
+  }
+  PrevSpeed = speed;
+  Duty = (uint32_t)u;
+  PWM_SetDuty(MOTOR_GEN, (uint32_t)u);
+  Motor_Compute = BSP_Cycles() - start;
+  if(Motor_Compute > Motor_ComputeMax){
+    Motor_ComputeMax = Motor_Compute;
+  }
+  Motor_Runs++;
+}
+
+// ******** Motor_Start ************
+// start the speed controller at set speed 0; call after Motor_Init and
+// Encoder_Init, it runs once interrupts are enabled
+// Inputs: gains (copied)
+// Outputs: 1 if started, 0 if Timer3 is taken
+int Motor_Start(const struct Motor_Gains *gains){
+  if(!Timer_Open(MOTOR_TIMER, "motor control")){
+    return 0;
+  }
+  Gains = *gains;
+  Target = 0;
+  Integral = 0;
+  PrevSpeed = 0;
+  Motor_Jitter = Motor_JitterMax = 0;
+  Motor_Compute = Motor_ComputeMax = Motor_Runs = 0;
+  Woke = 0;
+  Period = PLL_BusClock()/MOTOR_CTRLFREQ;
+  Timer_Periodic(MOTOR_TIMER, Period, MOTOR_CTRLPRI, &Control);
+  Due = BSP_Cycles() + Period;
+  return 1;
+}
+
+// ******** Motor_SetGains ************
+// new gains from the next control period; the integral restarts
+// Inputs: gains (copied)
+// Outputs: none
+void Motor_SetGains(const struct Motor_Gains *gains){
+  uint32_t sr = StartCritical();
+  Gains = *gains;
+  NewGains = 1;
+  EndCritical(sr);
+}
+
+// ******** Motor_SetSpeed ************
+// Inputs: output shaft speed in 1/100 RPM, 0 to stop
+// Outputs: none
+void Motor_SetSpeed(uint32_t speed){
+  Target = speed;
+}
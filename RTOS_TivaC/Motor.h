@@ -0,0 +1,88 @@
+// Motor.h
+// Runs on TM4C123
+// DC motor on an H-bridge driven by PWM generator 2 of module 0:
+// M0PWM4 on PE4 to the high side, M0PWM5 on PE5 (its complement, with
+// MOTOR_DEAD_NS dead-band) to the low side, and the bridge's fault
+// output on PD2 (M0FAULT0), which turns both off in hardware.
+// Speed control: a background periodic thread on Timer3A, so it runs at
+// MOTOR_CTRLFREQ whatever the foreground threads do, ends the encoder's
+// window (Encoder_Latch), runs a fixed-point PID with feed-forward and
+// anti-windup on the speed Encoder_Thread estimated from the windows
+// before, so one period behind, and writes the duty.  Each run records how late it started against the nominal
+// schedule (jitter) and how long it took, in bus cycles.
+// While stopped the PWM and the loop pause for deep sleeps, see Motor.c.
+
+#ifndef __MOTOR_H__
+#define __MOTOR_H__
+
+#include <stdint.h>
+
+#define MOTOR_PWMFREQ  20000    // PWM frequency in Hz, above hearing
+#define MOTOR_DEAD_NS  500      // both sides off at each switch
+#define MOTOR_FULL     65536    // duty of Motor_SetDuty, 1/65536 units
+#define MOTOR_CTRLFREQ 100      // control loop runs per second, one
+                                // per ENCODER_WINDOW_MS
+#define MOTOR_CTRLPRI  3        // below the encoder, above the LCD
+#define MOTOR_SHIFT    8        // gains are in 1/256
+
+// controller gains, in 1/2^MOTOR_SHIFT of duty (1/65536) per 1/100 RPM
+struct Motor_Gains{
+  int32_t kp;                   // proportional
+  int32_t ki;                   // integral, per control period
+  int32_t kd;                   // derivative of the speed, per period
+  int32_t kff;                  // feed-forward from the set speed
+  int32_t offset;               // feed-forward duty to get moving
+};
+
+// ******** Motor_Init ************
+// set up PE4, PE5, PD2 and the PWM, motor off; the PWM runs off the
+// bus clock, PLL_BusClock
+// Inputs: none
+// Outputs: 1 if the PWM started
+int Motor_Init(void);
+
+// ******** Motor_SetDuty ************
+// drive from the next PWM period on; constant, small cost
+// Inputs: duty 0 to MOTOR_FULL
+// Outputs: none
+void Motor_SetDuty(uint32_t duty);
+
+// ******** Motor_Faulted ************
+// Inputs: none
+// Outputs: 1 while the bridge fault has the outputs off
+int Motor_Faulted(void);
+
+// ******** Motor_Restart ************
+// run again after a fault, from 0% duty
+// Inputs: none
+// Outputs: none
+void Motor_Restart(void);
+
+// ******** Motor_Start ************
+// start the speed controller at set speed 0; call after Motor_Init and
+// Encoder_Init, it runs once interrupts are enabled; it runs
+// Encoder_Latch every period, so nothing else should; add
+// Encoder_Thread for the speed it controls
+// Inputs: gains (copied)
+// Outputs: 1 if started, 0 if Timer3 is taken
+int Motor_Start(const struct Motor_Gains *gains);
+
+// ******** Motor_SetGains ************
+// new gains from the next control period; the integral restarts
+// Inputs: gains (copied)
+// Outputs: none
+void Motor_SetGains(const struct Motor_Gains *gains);
+
+// ******** Motor_SetSpeed ************
+// Inputs: output shaft speed in 1/100 RPM, 0 to stop
+// Outputs: none
+void Motor_SetSpeed(uint32_t speed);
+
+// control loop timing, in bus cycles: how far from its slot in the
+// nominal schedule (the start plus whole periods) the last run started
+// and the worst so far, how long the last run took and the longest,
+// and the number of runs
+extern volatile uint32_t Motor_Jitter, Motor_JitterMax;
+extern volatile uint32_t Motor_Compute, Motor_ComputeMax, Motor_Runs;
+
+#endif
@@ -0,0 +1,194 @@
+// PWM.c
+// Runs on TM4C123
+// PWM generators, see PWM.h.  Like the Timer driver, the generators are
+// one block of registers at different addresses, reached through
+// HWREG(base + offset) from a table.
+// Output A is set when the count passes CMPA going down and cleared
+// when it passes CMPA going up, so it is high for 2*CMPA of the 2*LOAD
+// clocks of a period.  CMPA is clamped to 1..LOAD-1, a compare that
+// always matches; 0% and 100% instead switch GENA to driving A low or
+// high at both zero and LOAD, so there is no pulse or gap at all.  GENA
+// loads at the zero count like CMPA, so the switch is glitch-free.
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "PWM.h"
+#include "Clock.h"
+
+#ifndef HWREG
+#define HWREG(addr) (*((volatile uint32_t *)(addr)))
+#endif
+
+// module registers
+#define ENABLE   0x008          // output enables, two bits per generator
+#define FAULT    0x010          // outputs forced to FAULTVAL on a fault
+#define FAULTVAL 0x024
+// generator registers, from the generator's base
+#define CTL      0x000
+#define LOAD     0x010
+#define CMPA     0x018
+#define GENA     0x020
+#define GENB     0x024
+#define DBCTL    0x028
+#define DBRISE   0x02C
+#define DBFALL   0x030
+#define FLTSRC0  0x034
+// extended fault registers, from the module's base + 0x800 + 0x80*gen
+#define FLTSEN   0x000
+#define FLTSTAT0 0x004
+
+// GENA: high when the count passes CMPA going down, low going up, and
+// high at zero, where the pulse is centered, so A is right from the
+// first zero after 0%; the fixed levels of 0% and 100%
+#define GEN_UPDOWN  ((0x3<<6)|(0x2<<4)|0x3) // ACTCMPAD one, ACTCMPAU zero, ACTZERO one
+#define GEN_LOW     ((0x2<<2)|0x2)        // ACTLOAD and ACTZERO zero
+#define GEN_HIGH    ((0x3<<2)|0x3)        // ACTLOAD and ACTZERO one
+#define CTL_RUN (PWM_2_CTL_ENABLE|PWM_2_CTL_MODE|  /* count up/down */ \
+                 PWM_2_CTL_GENAUPD_LS|PWM_2_CTL_GENBUPD_LS|            \
+                 PWM_2_CTL_DBCTLUPD_LS|PWM_2_CTL_DBRISEUPD_LS|         \
+                 PWM_2_CTL_DBFALLUPD_LS) /* LOAD, CMPA at zero too */
+
+static const uint32_t Module[2] = {0x40028000, 0x40029000};
+
+static uint16_t Load[PWM_COUNT];
+static uint32_t Freq[PWM_COUNT];
+
+static uint32_t ModBase(uint32_t gen){
+  return Module[gen/4];
+}
+
+static uint32_t GenBase(uint32_t gen){
+  return Module[gen/4] + 0x40 + 0x40*(gen%4);
+}
+
+static uint32_t ExtBase(uint32_t gen){
+  return Module[gen/4] + 0x800 + 0x80*(gen%4);
+}
+
+// ******** PWM_Open ************
+// start a generator at 0% duty: A low, B high
+// Inputs: generator, PWM clock in Hz (the bus clock), frequency in Hz
+//         (PWM clock/131070 up to PWM clock/4), dead-band in PWM clocks
+//         (0 for B as a plain complement), 1 to shut down on MnFAULT0
+//         high
+// Outputs: 1 if started, 0 if the frequency is out of range
+int PWM_Open(uint32_t gen, uint32_t clock, uint32_t freq, uint32_t dead,
+             int fault){
+  uint32_t load, base, mod, outputs;
+  if((gen >= PWM_COUNT) || (freq == 0)){
+    return 0;
+  }
+  load = clock/(2*freq);        // up and down is two LOADs per period
+  if((load < 2) || (load > 0xFFFF)){
+    return 0;
+  }
+  base = GenBase(gen);
+  mod = ModBase(gen);
+  outputs = 0x3u<<(2*(gen%4));
+  if(Freq[gen] == 0){           // one user per generator
+    Clock_Acquire(CLOCK_PWM, gen/4);
+  }
+  HWREG(mod+ENABLE) &= ~outputs;
+  HWREG(base+CTL) = 0;          // stop during setup
+  Load[gen] = load;
+  Freq[gen] = freq;
+  HWREG(base+LOAD) = load;
+  HWREG(base+CMPA) = 1;         // see the clamp in PWM_SetDuty
+  HWREG(base+GENA) = GEN_LOW;   // 0%
+  HWREG(base+GENB) = GEN_UPDOWN;// unused with the dead-band on
+  HWREG(base+DBRISE) = dead&0xFFF;
+  HWREG(base+DBFALL) = dead&0xFFF;
+  HWREG(base+DBCTL) = 1;        // B is A inverted, both edges delayed
+  if(fault){
+    HWREG(ExtBase(gen)+FLTSEN) = 0;     // fault input active high
+    HWREG(base+FLTSRC0) = 0x1;          // MnFAULT0
+    HWREG(mod+FAULTVAL) &= ~outputs;    // low while faulted
+    HWREG(mod+FAULT) |= outputs;
+    HWREG(base+CTL) = CTL_RUN|PWM_2_CTL_FLTSRC|PWM_2_CTL_LATCH;
+  } else{
+    HWREG(mod+FAULT) &= ~outputs;
+    HWREG(base+CTL) = CTL_RUN;
+  }
+  HWREG(mod+ENABLE) |= outputs;
+  return 1;
+}
+
+// ******** PWM_SetClock ************
+// the PWM clock changed: same frequency, duty and dead time from the
+// next period on; LOAD, CMPA and the dead band all update at the next
+// zero count, so no period mixes old and new values
+// Inputs: generator, new PWM clock in Hz, dead-band in new PWM clocks
+// Outputs: 1 if done, 0 if the frequency is out of range at this clock
+int PWM_SetClock(uint32_t gen, uint32_t clock, uint32_t dead){
+  uint32_t base, load, cmp;
+  if((gen >= PWM_COUNT) || (Freq[gen] == 0)){
+    return 0;
+  }
+  load = clock/(2*Freq[gen]);
+  if((load < 2) || (load > 0xFFFF)){
+    return 0;
+  }
+  base = GenBase(gen);
+  cmp = HWREG(base+CMPA)*load/Load[gen];
+  if(cmp < 1){
+    cmp = 1;
+  } else if(cmp > load - 1){
+    cmp = load - 1;
+  }
+  Load[gen] = load;
+  HWREG(base+LOAD) = load;
+  HWREG(base+CMPA) = cmp;
+  HWREG(base+DBRISE) = dead&0xFFF;
+  HWREG(base+DBFALL) = dead&0xFFF;
+  return 1;
+}
+
+// ******** PWM_SetDuty ************
+// new duty cycle from the next period on; constant time, one multiply
+// and two stores, safe from any thread or interrupt; 0 and PWM_DUTYMAX
+// hold A low or high
+// Inputs: generator, duty 0 to PWM_DUTYMAX
+// Outputs: none
+void PWM_SetDuty(uint32_t gen, uint32_t duty){
+  uint32_t base = GenBase(gen);
+  uint32_t load = Load[gen];
+  uint32_t cmp = (load*duty)>>16;
+  uint32_t gena = GEN_UPDOWN;
+  if(duty == 0){
+    gena = GEN_LOW;
+  } else if(duty >= PWM_DUTYMAX){
+    gena = GEN_HIGH;
+  }
+  if(cmp < 1){
+    cmp = 1;
+  } else if(cmp > load - 1){
+    cmp = load - 1;
+  }
+  HWREG(base+CMPA) = cmp;       // both load at the next zero count
+  HWREG(base+GENA) = gena;
+}
+
+// ******** PWM_Stop ************
+// both outputs low now, generator off
+// Inputs: generator
+// Outputs: none
+void PWM_Stop(uint32_t gen){
+  HWREG(ModBase(gen)+ENABLE) &= ~(0x3u<<(2*(gen%4)));
+  HWREG(GenBase(gen)+CTL) = 0;
+}
+
+// ******** PWM_Faulted ************
+// Inputs: generator
+// Outputs: 1 while the outputs are shut down by the fault input
+int PWM_Faulted(uint32_t gen){
+  return (HWREG(ExtBase(gen)+FLTSTAT0)&0x1) != 0;
+}
+
+// ******** PWM_ClearFault ************
+// let the outputs run again once the fault input is low; call
+// PWM_SetDuty first if the duty should change
+// Inputs: generator
+// Outputs: none
+void PWM_ClearFault(uint32_t gen){
+  HWREG(ExtBase(gen)+FLTSTAT0) = 0x1; // write 1 to clear the latch
+}
@@ -0,0 +1,76 @@
+// PWM.h
+// Runs on TM4C123
+// Driver for the 8 PWM generators, 0-3 of module 0 (M0PWM0-7) and 0-3
+// of module 1 (M1PWM0-7).  A generator counts up and down, so its
+// pulses are centered in the period; output A is high for duty/
+// PWM_DUTYMAX of each period, held low at 0 and high at PWM_DUTYMAX,
+// and output B is its complement with dead-band delays, ready for the
+// two sides of an H-bridge.  Duty and period changes are buffered by
+// the hardware and take effect when the counter reaches zero, the end
+// of a period, so no period is cut.
+// A fault input (MnFAULT0) drives both outputs low and holds them
+// there until PWM_ClearFault.
+// The pins are muxed by the caller (GPIO AFSEL/PCTL).
+
+#ifndef __PWM_H__
+#define __PWM_H__
+
+#include <stdint.h>
+
+// generator numbers
+#define PWM0_GEN0    0          // M0PWM0/1
+#define PWM0_GEN1    1          // M0PWM2/3
+#define PWM0_GEN2    2          // M0PWM4/5
+#define PWM0_GEN3    3          // M0PWM6/7
+#define PWM1_GEN0    4          // M1PWM0/1
+#define PWM1_GEN1    5          // M1PWM2/3
+#define PWM1_GEN2    6          // M1PWM4/5
+#define PWM1_GEN3    7          // M1PWM6/7
+#define PWM_COUNT    8
+
+#define PWM_DUTYMAX  65536      // duty cycles are in 1/65536
+
+// ******** PWM_Open ************
+// start a generator at 0% duty: A low, B high
+// Inputs: generator, PWM clock in Hz (the bus clock), frequency in Hz
+//         (PWM clock/131070 up to PWM clock/4), dead-band in PWM clocks
+//         (0 for B as a plain complement), 1 to shut down on MnFAULT0
+//         high
+// Outputs: 1 if started, 0 if the frequency is out of range
+int PWM_Open(uint32_t gen, uint32_t clock, uint32_t freq, uint32_t dead,
+             int fault);
+
+// ******** PWM_SetClock ************
+// the PWM clock changed (a new bus clock): same frequency, duty and
+// dead time from the next period on, the outputs keep running
+// Inputs: generator, new PWM clock in Hz, dead-band in new PWM clocks
+// Outputs: 1 if done, 0 if the frequency is out of range at this clock
+int PWM_SetClock(uint32_t gen, uint32_t clock, uint32_t dead);
+
+// ******** PWM_SetDuty ************
+// new duty cycle from the next period on; constant time, one multiply
+// and two stores, safe from any thread or interrupt; 0 and PWM_DUTYMAX
+// hold A low or high
+// Inputs: generator, duty 0 to PWM_DUTYMAX
+// Outputs: none
+void PWM_SetDuty(uint32_t gen, uint32_t duty);
+
+// ******** PWM_Stop ************
+// both outputs low now, generator off
+// Inputs: generator
+// Outputs: none
+void PWM_Stop(uint32_t gen);
+
+// ******** PWM_Faulted ************
+// Inputs: generator
+// Outputs: 1 while the outputs are shut down by the fault input
+int PWM_Faulted(uint32_t gen);
+
+// ******** PWM_ClearFault ************
+// let the outputs run again once the fault input is low; call
+// PWM_SetDuty first if the duty should change
+// Inputs: generator
+// Outputs: none
+void PWM_ClearFault(uint32_t gen);
+
+#endif
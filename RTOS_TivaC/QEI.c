@@ -0,0 +1,157 @@
+// QEI.c
+// Runs on TM4C123
+// Quadrature encoder on QEI0, see QEI.h.
+// The position counter runs over the full 32 bits (MAXPOS all ones), so
+// the signed difference between two readings is the motion in between
+// as long as it is under 2^31 counts a period.  Homing sets RESMODE,
+// which makes the module zero the count at the index pulse; the next
+// period interrupt sees the index in the raw status, takes the count as
+// the new 64-bit position and clears RESMODE again.
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "QEI.h"
+#include "Clock.h"
+#include "PLL.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+
+static uint32_t CountsPerRev = 1;
+static void (*Period)(void);
+static int64_t Position;        // at the end of the last period
+static uint32_t LastPos;        // QEI0_POS_R then
+static volatile int32_t Velocity;
+static volatile uint8_t Homing, Homed;
+volatile uint32_t QEI_Indexes, QEI_Errors;
+
+// new bus clock, called by PLL_SetFrequency: same velocity period from
+// the next one on (the one running is cut or stretched, once)
+static void Retime(uint32_t from, uint32_t to){
+  QEI0_LOAD_R = to/QEI_VELFREQ - 1;
+}
+
+// ******** QEI_Init ************
+// set up PD3, PD6, PD7 and QEI0 and start counting from position 0
+// Inputs: counts per output shaft turn (4 per encoder line, times the
+//         gear ratio), function to run in the interrupt at the end of
+//         each velocity period (may be 0)
+// Outputs: none
+void QEI_Init(uint32_t countsPerRev, void (*period)(void)){
+  CountsPerRev = countsPerRev ? countsPerRev : 1;
+  Period = period;
+  Position = 0;
+  LastPos = 0;
+  Velocity = 0;
+  Homing = Homed = 0;
+  QEI_Indexes = QEI_Errors = 0;
+
+  Clock_Acquire(CLOCK_QEI, 0);
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTD);
+  GPIO_PORTD_LOCK_R = GPIO_LOCK_KEY;    // PD7 is locked (NMI)
+  GPIO_PORTD_CR_R |= 0x80;
+  GPIO_PORTD_DIR_R &= ~0xC8;            // PD7, PD6, PD3 inputs
+  GPIO_PORTD_AMSEL_R &= ~0xC8;
+  GPIO_PORTD_AFSEL_R |= 0xC8;
+  GPIO_PORTD_PCTL_R = (GPIO_PORTD_PCTL_R&0x00FF0FFF)|0x66006000; // PhB0, PhA0, IDX0
+  GPIO_PORTD_DEN_R |= 0xC8;
+
+  QEI0_CTL_R = 0;                       // disable during setup
+  QEI0_MAXPOS_R = 0xFFFFFFFF;           // count over the full 32 bits
+  QEI0_POS_R = 0;
+  QEI0_LOAD_R = PLL_BusClock()/QEI_VELFREQ - 1; // velocity period
+  PLL_Register(&Retime);
+  QEI0_ISC_R = QEI_ISC_ERROR|QEI_ISC_DIR|QEI_ISC_TIMER|QEI_ISC_INDEX;
+  QEI0_INTEN_R = QEI_INTEN_TIMER;       // only the end of each period
+  NVIC_PRI3_R = (NVIC_PRI3_R&0xFFFF1FFF)|(QEI_PRI<<13); // IRQ 13
+  NVIC_EN0_R = 1<<13;
+  QEI0_CTL_R = QEI_CTL_CAPMODE|         // both edges of both phases
+               QEI_CTL_VELEN|QEI_CTL_VELDIV_1|
+               QEI_CTL_FILTEN|(2<<QEI_CTL_FILTCNT_S)| // ignore glitches
+               QEI_CTL_ENABLE;
+}
+
+// end of a velocity period
+void Quadrature0_Handler(void){
+  uint32_t ris = QEI0_RIS_R;
+  uint32_t pos = QEI0_POS_R;
+  uint32_t speed = QEI0_SPEED_R;
+  if(Homing && !(ris&QEI_RIS_INDEX) && (QEI0_RIS_R&QEI_RIS_INDEX)){
+    ris |= QEI_RIS_INDEX;       // the index reset the count just now
+    pos = QEI0_POS_R;
+  }
+  QEI0_ISC_R = ris;             // index and errors are only polled
+  if(ris&QEI_RIS_INDEX){
+    QEI_Indexes++;
+  }
+  if(ris&QEI_RIS_ERROR){
+    QEI_Errors++;
+  }
+  if(Homing && (ris&QEI_RIS_INDEX)){
+    QEI0_CTL_R &= ~QEI_CTL_RESMODE;
+    Position = (int32_t)pos;    // counted from the index
+    Homing = 0;
+    Homed = 1;
+  } else{
+    Position += (int32_t)(pos - LastPos);
+  }
+  LastPos = pos;
+  Velocity = (QEI0_STAT_R&QEI_STAT_DIRECTION) ? -(int32_t)speed : (int32_t)speed;
+  if(Period){
+    (*Period)();
+  }
+}
+
+// ******** QEI_Position ************
+// Inputs: none
+// Outputs: counts since QEI_Init or the last homing index, negative
+//          behind it
+int64_t QEI_Position(void){
+  uint32_t sr = StartCritical();
+  int64_t position;
+  if(Homing){
+    position = Position;        // the count may be reset any moment
+  } else{
+    position = Position + (int32_t)(QEI0_POS_R - LastPos);
+  }
+  EndCritical(sr);
+  return position;
+}
+
+// ******** QEI_Velocity ************
+// Inputs: none
+// Outputs: counts in the last velocity period, negative in reverse
+int32_t QEI_Velocity(void){
+  return Velocity;
+}
+
+// ******** QEI_Speed ************
+// Inputs: none
+// Outputs: output shaft speed over the last velocity period, in
+//          1/QEI_SCALE RPM, negative in reverse
+int32_t QEI_Speed(void){
+  return (int32_t)(((int64_t)Velocity*QEI_VELFREQ*60*QEI_SCALE)/CountsPerRev);
+}
+
+// ******** QEI_Home ************
+// make the next index pulse position 0
+// Inputs: none
+// Outputs: none
+void QEI_Home(void){
+  uint32_t sr = StartCritical();
+  if(QEI0_RIS_R&QEI_RIS_INDEX){
+    QEI_Indexes++;
+  }
+  QEI0_ISC_R = QEI_ISC_INDEX;   // only an index from now on counts
+  Homed = 0;
+  Homing = 1;
+  QEI0_CTL_R |= QEI_CTL_RESMODE;
+  EndCritical(sr);
+}
+
+// ******** QEI_Homed ************
+// Inputs: none
+// Outputs: 1 once the index pulse asked for by QEI_Home has come
+int QEI_Homed(void){
+  return Homed;
+}
@@ -0,0 +1,59 @@
+// QEI.h
+// Runs on TM4C123
+// Quadrature encoder on QEI0: PhA0 PD6, PhB0 PD7, IDX0 PD3.
+// The module counts every edge of both phases in hardware, up or down
+// with the direction, and measures velocity over a fixed period of its
+// own timer, so the CPU sees one interrupt per velocity period
+// (QEI_VELFREQ per second) whatever the motor speed.  The interrupt
+// extends the 32-bit position to 64 bits and picks up index pulses
+// and phase errors from the raw status.
+
+#ifndef __QEI_H__
+#define __QEI_H__
+
+#include <stdint.h>
+
+#define QEI_VELFREQ  100        // velocity periods per second
+#define QEI_PRI      2          // end-of-period interrupt priority (IRQ 13)
+#define QEI_SCALE    100        // speeds are in 1/100 RPM
+
+// ******** QEI_Init ************
+// set up PD3, PD6, PD7 and QEI0 and start counting from position 0
+// Inputs: counts per output shaft turn (4 per encoder line, times the
+//         gear ratio), function to run in the interrupt at the end of
+//         each velocity period (may be 0)
+// Outputs: none
+void QEI_Init(uint32_t countsPerRev, void (*period)(void));
+
+// ******** QEI_Position ************
+// Inputs: none
+// Outputs: counts since QEI_Init or the last homing index, negative
+//          behind it
+int64_t QEI_Position(void);
+
+// ******** QEI_Velocity ************
+// Inputs: none
+// Outputs: counts in the last velocity period, negative in reverse
+int32_t QEI_Velocity(void);
+
+// ******** QEI_Speed ************
+// Inputs: none
+// Outputs: output shaft speed over the last velocity period, in
+//          1/QEI_SCALE RPM, negative in reverse
+int32_t QEI_Speed(void);
+
+// ******** QEI_Home ************
+// make the next index pulse position 0
+// Inputs: none
+// Outputs: none
+void QEI_Home(void);
+
+// ******** QEI_Homed ************
+// Inputs: none
+// Outputs: 1 once the index pulse asked for by QEI_Home has come
+int QEI_Homed(void);
+
+// number of index pulses and of phase errors seen
+extern volatile uint32_t QEI_Indexes, QEI_Errors;
+
+#endif
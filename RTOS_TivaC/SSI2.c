@@ -1,60 +1,269 @@
-// Adapted from Professor Mazidi's code at microdigitaled.com
-//   cited at EduBase-V2 trainer website
-
-#include <stdint.h>
-#include "tm4c123gh6pm.h"
-#include "SSI2.h"
-
-// SPI functions for Tiva-C SSI2 module on EduBase-V2 board
-// Pinout: MOSI - PB7
-//         MISO - PB6 (not used)
-//         SCLK - PB4
-//         CS on PortC
-
-// enable SSI2 and associated GPIO pins
-// note: you must initialize your CS pin separately
-void SSI2_init(void) {
-  SYSCTL_RCGCSSI_R |= 0x04;    // enable clock to SSI2
-  SYSCTL_RCGCGPIO_R |= 0x02;   // enable clock to GPIOB
-
-  // PORTB 7, 4 for SSI2 TX and SCLK
-  GPIO_PORTB_AMSEL_R &= ~0x90;      // turn off analog of PORTB 7, 4
-  GPIO_PORTB_AFSEL_R |= 0x90;       // PORTB 7, 4 for alternate function
-  GPIO_PORTB_PCTL_R &= ~0xF00F0000; // clear functions for PORTB 7, 4
-  GPIO_PORTB_PCTL_R |= 0x20020000;  // PORTB 7, 4 for SSI2 function
-  GPIO_PORTB_DEN_R |= 0x90;         // PORTB 7, 4 as digital pins
-
-  SSI2_CR1_R = 0;              // make it master
-  SSI2_CC_R = 0;               // use system clock
-  SSI2_CPSR_R = 16;            // clock prescaler divide by 16 gets 1 MHz clock
-  SSI2_CR0_R = 0x0007;         // clock rate div by 1, phase/polarity 0 0, mode freescale, data size 8
-  SSI2_CR1_R = 2;              // enable SSI2
-
-  return;
-}
-
-// enables chip select (using mask), writes one byte to SSI2,
-// waits for transmit to complete, and deasserts chip select (using mask)
-void SSI2_write( uint8_t data, uint8_t csMask ) {
-  GPIO_PORTC_DATA_R &= ~csMask;  // assert chip select
-  SSI2_DR_R = data;              // write data
-  while (SSI2_SR_R & 0x10) {}    // wait for transmit done
-  GPIO_PORTC_DATA_R |= csMask;   // deassert chip select
-}
-
-void displayDigit(uint8_t digit, uint8_t display)
-{
-
-  // translate from digit to 7-segment code
-  const static unsigned char digitPattern[] = {0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8, 0x80, 0x90};
-
-  // translate from display to 7-segment display to enable
-  const static unsigned char displayEnable[] = {0x08, 0x04, 0x02, 0x01};
-
-  // since 7Sdisplay works by using 2 shift registers, digit to display must be sent first
-  SSI2_write(digitPattern[digit], 0x80);
-
-  // now select the display to output to
-  SSI2_write(displayEnable[display], 0x80);
-
-}
+// Adapted from Professor Mazidi's code at microdigitaled.com
+//   cited at EduBase-V2 trainer website
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "SSI2.h"
+#include "os.h"
+#include "PLL.h"
+#include "Clock.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+void WaitForInterrupt(void);     // low power mode
+
+#define SSI2_PRI  3             // SSI2 interrupt priority, above the timer ISRs
+#define SSI2_BITRATE 500000     // SCLK in Hz, at most; the shift registers
+                                // and the LCD timing were checked at this
+
+// transaction in progress, owned by SSI2_Handler once started
+static const uint8_t *TxPt;     // next byte to send
+static volatile uint32_t TxCount; // bytes not yet in the FIFO
+static uint8_t TxCS;            // chip select mask on PORTC
+static void (*TxDone)(void);    // called when the transaction is latched
+static volatile uint8_t TxBusy;
+static uint32_t (*TxRepair)(const uint8_t **data); // sharer's bytes, once
+
+// another master on MOSI/SCLK, see SSI2_Share
+static void (*SharePause)(void);
+static uint32_t (*ShareRepair)(const uint8_t **data);
+static void (*ShareResume)(void);
+
+int32_t SSI2Free = 1;           // threads take turns in SSI2_Transfer
+int32_t SSI2Done = 0;           // signaled when their transaction is latched
+
+// prescaler for SSI2_BITRATE or just under at the bus clock: even,
+// 2 to 254 (SCR stays 0, 254 is enough up to 127 MHz)
+static uint32_t Prescale(uint32_t bus){
+  uint32_t cpsr = (bus + 2*SSI2_BITRATE - 1)/(2*SSI2_BITRATE)*2;
+  if(cpsr < 2){
+    cpsr = 2;
+  } else if(cpsr > 254){
+    cpsr = 254;
+  }
+  return cpsr;
+}
+
+// new bus clock, called by PLL_SetFrequency with interrupts disabled
+// BSY stays set until the FIFO is empty, so what was queued goes out
+// at the old rate first, 8 bytes in 128 us at most
+static void Retime(uint32_t from, uint32_t to){
+  while(SSI2_SR_R & SSI_SR_BSY){};
+  SSI2_CR1_R &= ~SSI_CR1_SSE;
+  SSI2_CPSR_R = Prescale(to);
+  SSI2_CR1_R |= SSI_CR1_SSE;
+}
+
+// SPI functions for Tiva-C SSI2 module on EduBase-V2 board
+// Pinout: MOSI - PB7
+//         MISO - PB6 (not used)
+//         SCLK - PB4
+//         CS on PortC
+
+// enable SSI2 and associated GPIO pins
+// note: you must initialize your CS pin separately
+// every device on the bus calls it; only the first sets SSI2 up
+void SSI2_init(void) {
+  if(Clock_Acquire(CLOCK_SSI, 2) == 0){
+    return;                    // another device set it up already
+  }
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTB);
+
+  // PORTB 7, 4 for SSI2 TX and SCLK
+  GPIO_PORTB_AMSEL_R &= ~0x90;      // turn off analog of PORTB 7, 4
+  GPIO_PORTB_AFSEL_R |= 0x90;       // PORTB 7, 4 for alternate function
+  GPIO_PORTB_PCTL_R &= ~0xF00F0000; // clear functions for PORTB 7, 4
+  GPIO_PORTB_PCTL_R |= 0x20020000;  // PORTB 7, 4 for SSI2 function
+  GPIO_PORTB_DEN_R |= 0x90;         // PORTB 7, 4 as digital pins
+
+  SSI2_CR1_R = 0;              // make it master
+  SSI2_CC_R = 0;               // use system clock
+  SSI2_CPSR_R = Prescale(PLL_BusClock()); // SSI2_BITRATE, 16 at 8 MHz
+  SSI2_CR0_R = 0x0007;         // clock rate div by 1, phase/polarity 0 0, mode freescale, data size 8
+  SSI2_IM_R = 0;               // TX interrupt armed per transaction
+  SSI2_CR1_R = 2;              // enable SSI2
+
+  NVIC_PRI14_R = (NVIC_PRI14_R&0xFFFF00FF)|(SSI2_PRI<<13); // IRQ 57
+  NVIC_EN1_R = 1<<(57-32);     // enable IRQ 57 in NVIC
+  TxBusy = 0;
+  PLL_Register(&Retime);
+
+  return;
+}
+
+// Moves the transaction along; called from SSI2_Handler, or with
+// interrupts disabled when polling.  With EOT clear TXRIS means the FIFO
+// is half empty, so it is topped up; after the last byte EOT is set and
+// TXRIS means the last bit is out, so the chip select can latch it.
+// EOT is switched with SSE set; it only selects what TXRIS reports.
+// In latch-each mode EOT stays set and one byte is sent per latch.
+// Last come the sharer's repair bytes, with no chip select to raise.
+static void Service(void){
+  void (*done)(void);
+  if(SSI2_CR1_R & SSI_CR1_EOT){     // waiting for the last bit
+    if(SSI2_SR_R & SSI_SR_BSY){
+      return;
+    }
+    GPIO_PORTC_DATA_R |= TxCS;      // rising edge latches the shift register
+    if(TxCount){                    // latch-each, next byte
+      GPIO_PORTC_DATA_R &= ~TxCS;
+      SSI2_DR_R = *TxPt++;
+      TxCount--;
+      return;
+    }
+    if(TxRepair){                   // put back what the sharer had shifted
+      TxCount = TxRepair(&TxPt);
+      TxRepair = 0;
+      TxCS = 0;
+      if(TxCount){
+        SSI2_CR1_R &= ~SSI_CR1_EOT;
+        Service();                  // fill the FIFO
+        return;
+      }
+    }
+    SSI2_IM_R &= ~SSI_IM_TXIM;      // done
+    SSI2_CR1_R &= ~SSI_CR1_EOT;
+    done = TxDone;
+    TxBusy = 0;
+    if(ShareResume){
+      ShareResume();
+    }
+    if(done){
+      done();
+    }
+    return;
+  }
+  while(TxCount && (SSI2_SR_R & SSI_SR_TNF)){ // keep the FIFO full
+    SSI2_DR_R = *TxPt++;
+    TxCount--;
+  }
+  if(TxCount == 0){
+    SSI2_CR1_R |= SSI_CR1_EOT;      // interrupt when it has all gone out
+  }
+}
+
+void SSI2_Handler(void){
+  Service();
+}
+
+int SSI2_Start( const uint8_t *data, uint32_t count, uint8_t csMask,
+                uint32_t flags, void (*done)(void) ){
+  uint32_t sr = StartCritical();
+  if(TxBusy || (count == 0)){
+    EndCritical(sr);
+    return 0;
+  }
+  TxBusy = 1;
+  TxPt = data;
+  TxCount = count;
+  TxCS = csMask;
+  TxDone = done;
+  TxRepair = ShareRepair;
+  if(SharePause){
+    SharePause();                  // nothing else reaches the FIFO now
+  }
+  GPIO_PORTC_DATA_R &= ~csMask;    // assert chip select
+  if(flags&SSI2_LATCH_EACH){
+    SSI2_CR1_R |= SSI_CR1_EOT;
+    SSI2_DR_R = *TxPt++;
+    TxCount--;
+  } else{
+    Service();                     // fill the FIFO
+  }
+  SSI2_IM_R |= SSI_IM_TXIM;        // SSI2_Handler does the rest
+  EndCritical(sr);
+  return 1;
+}
+
+int SSI2_Busy(void){
+  return TxBusy;
+}
+
+void SSI2_Share( void (*pause)(void), uint32_t (*repair)(const uint8_t **data),
+                 void (*resume)(void) ){
+  uint32_t sr = StartCritical();
+  SharePause = pause;
+  ShareRepair = repair;
+  ShareResume = resume;
+  EndCritical(sr);
+}
+
+// run the state machine by hand until the bus is free
+static void Poll(void){
+  uint32_t sr;
+  while(TxBusy){
+    sr = StartCritical();
+    Service();
+    EndCritical(sr);
+  }
+}
+
+// sleep until the bus is free; checking with interrupts disabled means
+// the last interrupt can't slip in between the check and the WFI
+static void Sleep(void){
+  uint32_t sr = StartCritical();
+  while(TxBusy){
+    WaitForInterrupt();            // wakes on the pending interrupt
+    EndCritical(sr);               // let it run
+    sr = StartCritical();
+  }
+  EndCritical(sr);
+}
+
+static void TransferDone(void){
+  OS_Signal(&SSI2Done);
+}
+
+void SSI2_Transfer( const uint8_t *data, uint32_t count, uint8_t csMask,
+                    uint32_t flags ){
+  uint32_t sr;
+  if(count == 0){
+    return;
+  }
+  sr = StartCritical();
+  EndCritical(sr);
+  if(sr || (NVIC_INT_CTRL_R&NVIC_INT_CTRL_VEC_ACT_M)){
+    do{
+      Poll();                      // ISR or interrupts off: nothing can wait
+    } while(!SSI2_Start(data, count, csMask, flags, 0));
+    Poll();
+  } else if(OS_Running()){
+    OS_Wait(&SSI2Free);
+    while(!SSI2_Start(data, count, csMask, flags, &TransferDone)){
+      OS_Suspend();                // started by SSI2_Start from elsewhere
+    }
+    OS_Wait(&SSI2Done);            // other threads run meanwhile
+    OS_Signal(&SSI2Free);
+  } else{
+    do{
+      Sleep();                     // no other thread to run
+    } while(!SSI2_Start(data, count, csMask, flags, 0));
+    Sleep();
+  }
+}
+
+// enables chip select (using mask), writes one byte to SSI2,
+// waits for transmit to complete, and deasserts chip select (using mask)
+void SSI2_write( uint8_t data, uint8_t csMask ) {
+  SSI2_Transfer(&data, 1, csMask, SSI2_LATCH_END);
+}
+
+// writes the shift registers directly, so don't use it while the
+// SevenSeg.c scan is running
+void displayDigit(uint8_t digit, uint8_t display)
+{
+
+  // translate from digit to 7-segment code
+  const static unsigned char digitPattern[] = {0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8, 0x80, 0x90};
+
+  // translate from display to 7-segment display to enable
+  const static unsigned char displayEnable[] = {0x08, 0x04, 0x02, 0x01};
+
+  // since 7Sdisplay works by using 2 shift registers, digit to display must be sent first,
+  // then the display to output to; one latch for both, so no other digit flashes in between
+  uint8_t frame[2];
+  frame[0] = digitPattern[digit];
+  frame[1] = displayEnable[display];
+  SSI2_Transfer(frame, 2, 0x80, SSI2_LATCH_END);
+
+}
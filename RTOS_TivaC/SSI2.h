@@ -1,25 +1,62 @@
-// Adapted from Professor Mazidi's code at microdigitaled.com
-//   cited at EduBase-V2 trainer website
-
-#ifndef __SSI2_H__
-#define __SSI2_H__
-
-// SPI functions for Tiva-C SSI2 module on EduBase-V2 board
-// Pinout: MOSI - PB7
-//         MISO - PB6 (not used)
-//         SCLK - PB4
-//         CS on PortC
-
-// enable SSI2 and associated GPIO pins
-// note: you must initialize your CS pin separately
-void SSI2_init(void);
-
-// enables chip select (using mask), writes one byte to SSI2,
-// waits for transmit to complete, and deasserts chip select (using mask)
-void SSI2_write( uint8_t data, uint8_t csMask );
-
-
-// helper function to display a digit on the 7-segment display
-void displayDigit( uint8_t digit, uint8_t display );
-
-#endif
+// Adapted from Professor Mazidi's code at microdigitaled.com
+//   cited at EduBase-V2 trainer website
+
+#ifndef __SSI2_H__
+#define __SSI2_H__
+
+// SPI functions for Tiva-C SSI2 module on EduBase-V2 board
+// Pinout: MOSI - PB7
+//         MISO - PB6 (not used)
+//         SCLK - PB4
+//         CS on PortC
+
+// enable SSI2 and associated GPIO pins
+// note: you must initialize your CS pin separately
+// every device on the bus calls it; only the first sets SSI2 up
+void SSI2_init(void);
+
+// flags for SSI2_Start and SSI2_Transfer
+#define SSI2_LATCH_END   0  // raise chip select once after the last byte
+                            // (chained shift registers, e.g. 7-segment)
+#define SSI2_LATCH_EACH  1  // raise chip select after every byte, so each
+                            // byte reaches the outputs (e.g. LCD E strobe)
+
+// starts a transaction and returns right away; the SSI2 interrupt keeps
+// the 8-deep TX FIFO full and calls done (may be 0) from interrupt
+// context when the chip select has been raised after the last byte.
+// data must stay valid until then.
+// returns 1 if started, 0 if a transaction is still in progress
+int SSI2_Start( const uint8_t *data, uint32_t count, uint8_t csMask,
+                uint32_t flags, void (*done)(void) );
+
+// sends count bytes as one transaction and returns when they are latched
+// a thread blocks on a semaphore while the interrupt does the work;
+// in an ISR or with interrupts disabled it polls the same state machine,
+// and with no kernel running it waits for the interrupt to finish
+void SSI2_Transfer( const uint8_t *data, uint32_t count, uint8_t csMask,
+                    uint32_t flags );
+
+// 1 while a transaction is in progress
+int SSI2_Busy(void);
+
+// register another master that writes SSI2_DR on its own (the 7-segment
+// scan uDMA).  Every transaction calls pause before it takes the FIFO;
+// once it is latched, the bytes repair returns (it sets *data, returns
+// the count, 0 for none) are shifted out without a chip select, so the
+// shift registers hold what the other master left in them, then resume
+// is called.  pause and repair run in SSI2_Start's critical section or
+// in SSI2_Handler.
+void SSI2_Share( void (*pause)(void), uint32_t (*repair)(const uint8_t **data),
+                 void (*resume)(void) );
+
+// enables chip select (using mask), writes one byte to SSI2,
+// waits for transmit to complete, and deasserts chip select (using mask)
+// same as SSI2_Transfer of one byte
+void SSI2_write( uint8_t data, uint8_t csMask );
+
+
+// helper function to display a digit on the 7-segment display
+// (CPU driven; SevenSeg.h scans all four digits by uDMA instead)
+void displayDigit( uint8_t digit, uint8_t display );
+
+#endif
@@ -0,0 +1,237 @@
+// SevenSeg.c
+// Runs on TM4C123 (EduBase-V2)
+// 7-segment display scanned by the uDMA, see SevenSeg.h.
+// The two chained 74HC595s take the segment pattern then the digit
+// enable, and PC7 rising latches both.  Each Timer1A time-out starts one
+// task of a looping peripheral scatter-gather list on channel 20:
+//   data    2 bytes {pattern, enable} from Frame[d] to SSI2_DR
+//   latch   2 bytes {0x00, 0x80} to the PC7 bit-specific data address
+//   pad     1 byte to a scratch variable, so every digit is lit for
+//           three periods; digit 3's pad is the task restarting the list
+// A frame is 12 time-outs, 125 Hz at SEVENSEG_SCANFREQ.
+// The LCD shares MOSI and SCLK.  SSI2 masks the channel's requests for
+// each LCD transaction, then, if the next task is a latch, shifts that
+// digit's bytes out again so the latch doesn't pick up LCD data.
+// While every digit is blank the scan has nothing to show, so Timer1A
+// and the channel may stand still through a deep sleep (BSP_DeepClient);
+// a digit blanked less than a frame before one can stay lit through it.
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "SevenSeg.h"
+#include "SSI2.h"
+#include "PLL.h"
+#include "Timer.h"
+#include "uDMA.h"
+#include "Clock.h"
+#include "BSP.h"
+
+#define TASKSPERDIGIT 3
+#define NUMTASKS      (TASKSPERDIGIT*SEVENSEG_DIGITS)
+#define LATCHTASK     1         // index of the latch within a digit's tasks
+#define BYTEFLAGS     (UDMA_8BIT|UDMA_DST_FIXED|UDMA_ARB(1)) // 2 bytes per request
+
+// active-low patterns for 0-9 and A-F
+static const uint8_t Glyph[16] = {
+  0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8,
+  0x80, 0x90, 0x88, 0x83, 0xC6, 0xA1, 0x86, 0x8E
+};
+static const uint8_t Enable[SEVENSEG_DIGITS] = {0x08, 0x04, 0x02, 0x01};
+static const uint8_t Latch[2] = {0x00, 0x80}; // PC7 low then high
+
+static uint8_t Frame[SEVENSEG_DIGITS][2]; // {pattern, enable}, read by the uDMA
+static uDMA_Task Tasks[NUMTASKS];
+static uDMA_Task Saved;         // primary structure the last task restores
+static uint8_t Scratch;         // destination of the pad tasks
+
+// SSI2 sharer hooks, called before and after every SSI2 transaction
+static void Pause(void){
+  uDMA_Mask(UDMA_TIMER1A, 1);
+}
+
+static uint32_t Repair(const uint8_t **data){
+  uint32_t remaining = uDMA_Remaining(UDMA_TIMER1A);
+  uint32_t next;
+  if(remaining == 0){
+    return 0;
+  }
+  next = NUMTASKS - remaining/4;  // 4 words per task
+  if((next%TASKSPERDIGIT) != LATCHTASK){
+    return 0;                     // no data waiting in the shift registers
+  }
+  *data = Frame[next/TASKSPERDIGIT];
+  return 2;
+}
+
+static void Resume(void){
+  uDMA_Mask(UDMA_TIMER1A, 0);
+}
+
+// deep sleep client: idle while the whole frame is blank
+static int Park(int sleep){
+  uint32_t d;
+  for(d = 0; d < SEVENSEG_DIGITS; d++){
+    if(Frame[d][0] != SEVENSEG_BLANK){
+      return 0;
+    }
+  }
+  return 1;                       // nothing to stop or restart
+}
+
+// ******** SevenSeg_Init ************
+// set up PC7, Timer1A and the uDMA list and start scanning a blank
+// display; brings up SSI2 and the uDMA too, if no one has yet
+// Inputs: none
+// Outputs: none
+void SevenSeg_Init(void){
+  uint32_t d;
+  volatile uint32_t *latch = &GPIO_PORTC_DATA_BITS_R[0x80]; // PC7 only
+
+  SSI2_init();
+  uDMA_Init();
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTC);
+  GPIO_PORTC_AMSEL_R &= ~0x80;          // disable analog of PORTC 7
+  GPIO_PORTC_DATA_R |= 0x80;            // set PORTC 7 idle high
+  GPIO_PORTC_DIR_R |= 0x80;             // set PORTC 7 as output for SS
+  GPIO_PORTC_DEN_R |= 0x80;             // set PORTC 7 as digital pin
+
+  for(d = 0; d < SEVENSEG_DIGITS; d++){
+    Frame[d][0] = SEVENSEG_BLANK;
+    Frame[d][1] = Enable[d];
+    uDMA_MakeTask(&Tasks[TASKSPERDIGIT*d], Frame[d], &SSI2_DR_R, 2,
+                  BYTEFLAGS, 1, 0);
+    uDMA_MakeTask(&Tasks[TASKSPERDIGIT*d+LATCHTASK], Latch, latch, 2,
+                  BYTEFLAGS, 1, 0);
+    uDMA_MakeTask(&Tasks[TASKSPERDIGIT*d+2], &Scratch, &Scratch, 1,
+                  UDMA_8BIT, 1, 0);
+  }
+  uDMA_LoopTask(&Tasks[NUMTASKS-1], &Saved, UDMA_TIMER1A, Tasks, NUMTASKS, 1);
+  SSI2_Share(&Pause, &Repair, &Resume);
+
+  uDMA_Assign(UDMA_TIMER1A, UDMA_TIMER_ENC);
+  uDMA_ScatterGather(UDMA_TIMER1A, Tasks, NUMTASKS, 1, 0);
+  if(Timer_Open(TIMER_1, "7-segment")){
+    // the time-out requests the uDMA, no callback so IRQ 21 stays off
+    Timer_Periodic(TIMER_1, PLL_BusClock()/SEVENSEG_SCANFREQ, 0, 0);
+  }
+  BSP_DeepClient(CLOCK_TIMER, 1u<<TIMER_1, &Park);
+  BSP_DeepClient(CLOCK_DMA, 1u<<UDMA_TIMER1A, &Park);
+}
+
+// ******** SevenSeg_Segments ************
+// show a raw pattern, decimal point included
+// Inputs: digit 0 to 3, active-low pattern
+// Outputs: none
+void SevenSeg_Segments(uint32_t digit, uint8_t pattern){
+  Frame[digit%SEVENSEG_DIGITS][0] = pattern;
+}
+
+// ******** SevenSeg_Digit ************
+// show one hexadecimal digit; the decimal point is left as it is
+// Inputs: digit 0 to 3, value 0 to 15
+// Outputs: none
+void SevenSeg_Digit(uint32_t digit, uint32_t value){
+  uint8_t *pt = &Frame[digit%SEVENSEG_DIGITS][0];
+  *pt = Glyph[value&0x0F]&(*pt|~SEVENSEG_DP);
+}
+
+// ******** SevenSeg_Blank ************
+// turn a digit off; the decimal point is left as it is
+// Inputs: digit 0 to 3
+// Outputs: none
+void SevenSeg_Blank(uint32_t digit){
+  Frame[digit%SEVENSEG_DIGITS][0] |= (uint8_t)~SEVENSEG_DP;
+}
+
+// ******** SevenSeg_Point ************
+// Inputs: digit 0 to 3, 1 to light its decimal point, 0 to clear it
+// Outputs: none
+void SevenSeg_Point(uint32_t digit, int on){
+  if(on){
+    Frame[digit%SEVENSEG_DIGITS][0] &= ~SEVENSEG_DP;
+  } else{
+    Frame[digit%SEVENSEG_DIGITS][0] |= SEVENSEG_DP;
+  }
+}
+
+// one byte store per digit, so the uDMA never sees half a pattern
+static void Show(const uint8_t pattern[SEVENSEG_DIGITS]){
+  uint32_t d;
+  for(d = 0; d < SEVENSEG_DIGITS; d++){
+    Frame[d][0] = pattern[d];
+  }
+}
+
+static void Overflow(void){
+  static const uint8_t dashes[SEVENSEG_DIGITS] = {
+    SEVENSEG_MINUS, SEVENSEG_MINUS, SEVENSEG_MINUS, SEVENSEG_MINUS
+  };
+  Show(dashes);
+}
+
+// ******** SevenSeg_OutUDec ************
+// unsigned decimal, right aligned with leading blanks
+// shows ---- above 9999
+// Inputs: number
+// Outputs: none
+void SevenSeg_OutUDec(uint32_t n){
+  if(n > 9999){
+    Overflow();
+    return;
+  }
+  SevenSeg_OutFix((int32_t)n, 0);
+}
+
+// ******** SevenSeg_OutUHex ************
+// four hexadecimal digits with leading zeros, low 16 bits only
+// Inputs: number
+// Outputs: none
+void SevenSeg_OutUHex(uint32_t n){
+  uint8_t pattern[SEVENSEG_DIGITS];
+  int i;
+  for(i = SEVENSEG_DIGITS-1; i >= 0; i--){
+    pattern[i] = Glyph[n&0x0F];
+    n = n>>4;
+  }
+  Show(pattern);
+}
+
+// ******** SevenSeg_OutFix ************
+// signed fixed point n/10^decimals, right aligned, with a zero before
+// the point, e.g. (-5, 2) shows -0.05; shows ---- when it doesn't fit
+// Inputs: number, digits after the decimal point 0 to 3
+// Outputs: none
+void SevenSeg_OutFix(int32_t n, uint32_t decimals){
+  uint8_t pattern[SEVENSEG_DIGITS];
+  uint32_t u = (n < 0) ? -(uint32_t)n : (uint32_t)n;
+  int i = SEVENSEG_DIGITS;
+  if(decimals >= SEVENSEG_DIGITS){
+    Overflow();
+    return;
+  }
+  do{                             // at least one digit left of the point
+    if(i == 0){
+      Overflow();
+      return;
+    }
+    i--;
+    pattern[i] = Glyph[u%10];
+    u = u/10;
+  } while(u || ((SEVENSEG_DIGITS-i) <= decimals));
+  if(n < 0){
+    if(i == 0){
+      Overflow();
+      return;
+    }
+    i--;
+    pattern[i] = SEVENSEG_MINUS;
+  }
+  while(i > 0){
+    i--;
+    pattern[i] = SEVENSEG_BLANK;
+  }
+  if(decimals){
+    pattern[SEVENSEG_DIGITS-1-decimals] &= ~SEVENSEG_DP;
+  }
+  Show(pattern);
+}
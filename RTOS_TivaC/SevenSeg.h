@@ -0,0 +1,71 @@
+// SevenSeg.h
+// Runs on TM4C123 (EduBase-V2)
+// Four-digit 7-segment display scanned by the uDMA.  Timer1A paces a
+// peripheral scatter-gather list that shifts each digit out of a frame
+// buffer over SSI2 and pulses the PC7 latch, so showing a value is just
+// a write into the frame buffer; no interrupt runs for the display.
+// Digits are numbered 0 (left) to 3; patterns are active low, bit 7 is
+// the decimal point.
+
+#ifndef __SEVENSEG_H__
+#define __SEVENSEG_H__
+
+#include <stdint.h>
+
+#define SEVENSEG_DIGITS   4
+#define SEVENSEG_SCANFREQ 1500  // timer requests per second, 12 per frame
+#define SEVENSEG_BLANK    0xFF  // all segments off
+#define SEVENSEG_MINUS    0xBF  // segment g only
+#define SEVENSEG_DP       0x80  // decimal point, cleared to light it
+
+// ******** SevenSeg_Init ************
+// set up PC7, Timer1A and the uDMA list and start scanning a blank
+// display; brings up SSI2 and the uDMA too, if no one has yet
+// Inputs: none
+// Outputs: none
+void SevenSeg_Init(void);
+
+// ******** SevenSeg_Segments ************
+// show a raw pattern, decimal point included
+// Inputs: digit 0 to 3, active-low pattern
+// Outputs: none
+void SevenSeg_Segments(uint32_t digit, uint8_t pattern);
+
+// ******** SevenSeg_Digit ************
+// show one hexadecimal digit; the decimal point is left as it is
+// Inputs: digit 0 to 3, value 0 to 15
+// Outputs: none
+void SevenSeg_Digit(uint32_t digit, uint32_t value);
+
+// ******** SevenSeg_Blank ************
+// turn a digit off; the decimal point is left as it is
+// Inputs: digit 0 to 3
+// Outputs: none
+void SevenSeg_Blank(uint32_t digit);
+
+// ******** SevenSeg_Point ************
+// Inputs: digit 0 to 3, 1 to light its decimal point, 0 to clear it
+// Outputs: none
+void SevenSeg_Point(uint32_t digit, int on);
+
+// ******** SevenSeg_OutUDec ************
+// unsigned decimal, right aligned with leading blanks
+// shows ---- above 9999
+// Inputs: number
+// Outputs: none
+void SevenSeg_OutUDec(uint32_t n);
+
+// ******** SevenSeg_OutUHex ************
+// four hexadecimal digits with leading zeros, low 16 bits only
+// Inputs: number
+// Outputs: none
+void SevenSeg_OutUHex(uint32_t n);
+
+// ******** SevenSeg_OutFix ************
+// signed fixed point n/10^decimals, right aligned, with a zero before
+// the point, e.g. (-5, 2) shows -0.05; shows ---- when it doesn't fit
+// Inputs: number, digits after the decimal point 0 to 3
+// Outputs: none
+void SevenSeg_OutFix(int32_t n, uint32_t decimals);
+
+#endif
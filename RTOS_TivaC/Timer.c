@@ -0,0 +1,469 @@
+// Timer.c
+// Runs on TM4C123
+// General-purpose timer driver, see Timer.h.  Every timer is the same
+// block of registers at a different base address, so the driver keeps
+// one table of bases and IRQ numbers and reaches the registers through
+// HWREG(base + offset) instead of the per-timer macros.
+// Only timer A of each block is used; in the split (16/32-bit) modes
+// timer B stays off.
+// In capture mode the timeout interrupt counts the wraps of the free
+// running counter.  When a wrap and an edge are handled together, an
+// edge in the upper half of the count came before the wrap, one in the
+// lower half after it; that is how the 64-bit timestamps stay exact.
+// An up-counting edge counter stops at its match value, so edge count
+// mode matches at the full width and the match interrupt restarts it
+// from 0 and counts the restarts; Timer_Read adds them back in.
+// On a bus clock change (PLL_SetFrequency) every running one-shot and
+// periodic count is scaled in place: TAILR for the period, then TAV
+// for what is left of the current one, so no timeout is lost or moved.
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "Timer.h"
+#include "Clock.h"
+#include "PLL.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+
+#ifndef HWREG
+#define HWREG(addr) (*((volatile uint32_t *)(addr)))
+#endif
+
+// register offsets from the timer's base address
+#define CFG      0x000
+#define TAMR     0x004
+#define CTL      0x00C
+#define IMR      0x018
+#define RIS      0x01C
+#define MIS      0x020
+#define ICR      0x024
+#define TAILR    0x028
+#define TBILR    0x02C
+#define TAMATCHR 0x030
+#define TAPR     0x038
+#define TAPMR    0x040
+#define TAR      0x048
+#define TAV      0x050
+
+// GPTMCFG
+#define CFG_FULL  0x0           // 32-bit (standard) or 64-bit (wide) count
+#define CFG_SPLIT 0x4           // 16-bit (standard) or 32-bit (wide) timer A
+// GPTMTAMR
+#define TAMR_1SHOT  0x001
+#define TAMR_PERIOD 0x002
+#define TAMR_CAP    0x003
+#define TAMR_TACMR  0x004       // edge time rather than edge count
+#define TAMR_TAAMS  0x008       // PWM
+#define TAMR_TACDIR 0x010       // count up
+#define TAMR_TAILD  0x100       // new TAILR at the timeout
+#define TAMR_TAMRSU 0x400       // new TAMATCHR at the timeout
+// GPTMCTL
+#define CTL_TAEN    0x001
+#define CTL_TAOTE   0x020       // timeouts trigger the ADC
+#define CTL_TAEVENT(e) (((e)&0x3)<<2)
+// GPTMIMR/RIS/MIS/ICR
+#define INT_TATO    0x001       // timeout
+#define INT_CAM     0x002       // capture match (edge count)
+#define INT_CAE     0x004       // capture event
+#define INT_ALL     0xFFF
+
+#define NVIC_PRI_BASE    0xE000E400
+#define NVIC_EN_BASE     0xE000E100
+#define NVIC_DIS_BASE    0xE000E180
+#define NVIC_UNPEND_BASE 0xE000E280
+
+// the modes, for Timer_Read and the handlers
+#define MODE_OFF       0
+#define MODE_ONESHOT   1
+#define MODE_PERIODIC  2
+#define MODE_CAPTURE   3
+#define MODE_EDGECOUNT 4
+#define MODE_PWM       5
+
+static const uint32_t Base[TIMER_COUNT] = {
+  0x40030000, 0x40031000, 0x40032000, 0x40033000, 0x40034000, 0x40035000,
+  0x40036000, 0x40037000, 0x4004C000, 0x4004D000, 0x4004E000, 0x4004F000
+};
+static const uint8_t Irq[TIMER_COUNT] = {
+  19, 21, 23, 35, 70, 92, 94, 96, 98, 100, 102, 104
+};
+
+static const char *Owner[TIMER_COUNT];
+static Timer_Callback Callback[TIMER_COUNT];
+static uint8_t Mode[TIMER_COUNT];
+static volatile uint32_t Captured[TIMER_COUNT];
+static volatile uint64_t Captured64[TIMER_COUNT];
+static volatile uint32_t Wraps[TIMER_COUNT]; // capture wrap-arounds,
+                                             // edge count restarts
+
+static int Wide(uint32_t timer){
+  return timer >= WTIMER_0;
+}
+
+// ******** Timer_Mask ************
+// Inputs: timer
+// Outputs: largest capture timestamp, 0x00FFFFFF on a standard timer,
+//          0xFFFFFFFF on a wide one
+uint32_t Timer_Mask(uint32_t timer){
+  return Wide(timer) ? 0xFFFFFFFF : 0x00FFFFFF;
+}
+
+static void IrqEnable(uint32_t timer, uint32_t priority){
+  uint32_t irq = Irq[timer];
+  uint32_t shift = 8*(irq&3) + 5;
+  volatile uint32_t *pri = &HWREG(NVIC_PRI_BASE + (irq&~3));
+  *pri = (*pri&~(0x7u<<shift))|((priority&0x7)<<shift);
+  HWREG(NVIC_EN_BASE + 4*(irq/32)) = 1u<<(irq%32);
+}
+
+static void IrqDisable(uint32_t timer){
+  uint32_t irq = Irq[timer];
+  HWREG(NVIC_DIS_BASE + 4*(irq/32)) = 1u<<(irq%32);
+  HWREG(NVIC_UNPEND_BASE + 4*(irq/32)) = 1u<<(irq%32);
+}
+
+// stopped, interrupts off, ready for a new mode
+static void Reset(uint32_t timer, uint32_t mode){
+  uint32_t base = Base[timer];
+  HWREG(base+CTL) = 0;
+  HWREG(base+IMR) = 0;
+  HWREG(base+ICR) = INT_ALL;
+  IrqDisable(timer);
+  HWREG(base+TAPR) = 0;
+  HWREG(base+TAPMR) = 0;
+  Callback[timer] = 0;
+  Mode[timer] = mode;
+}
+
+// load a split-mode value, the prescaler holding bits 23-16 on a
+// standard timer
+static void Split(uint32_t timer, uint32_t reg, uint32_t prescale, uint32_t n){
+  uint32_t base = Base[timer];
+  if(Wide(timer)){
+    HWREG(base+reg) = n;
+  } else{
+    HWREG(base+reg) = n&0xFFFF;
+    HWREG(base+prescale) = (n>>16)&0xFF;
+  }
+}
+
+// n bus cycles at from Hz, in cycles at to Hz, 1 to 0xFFFFFFFF
+static uint32_t Scale(uint32_t n, uint32_t from, uint32_t to){
+  uint64_t m = (uint64_t)n*to/from;
+  if(m > 0xFFFFFFFF){
+    return 0xFFFFFFFF;
+  }
+  return m ? (uint32_t)m : 1;
+}
+
+// new bus clock, called by PLL_SetFrequency with interrupts disabled
+// timeouts keep their time; capture, edge count and PWM are left alone
+// (their owners know what their counts mean)
+static void Retime(uint32_t from, uint32_t to){
+  uint32_t timer, base;
+  for(timer = 0; timer < TIMER_COUNT; timer++){
+    base = Base[timer];
+    if(((Mode[timer] == MODE_ONESHOT) || (Mode[timer] == MODE_PERIODIC)) &&
+       (HWREG(base+CTL)&CTL_TAEN)){
+      HWREG(base+TAILR) = Scale(HWREG(base+TAILR) + 1, from, to) - 1;
+      HWREG(base+TAV) = Scale(HWREG(base+TAV), from, to);
+    }
+  }
+}
+
+// ******** Timer_Open ************
+// claim a timer and turn its clock on
+// Inputs: timer, name of the owner (kept, for Timer_Owner)
+// Outputs: 1 if claimed, 0 if someone else owns it
+int Timer_Open(uint32_t timer, const char *owner){
+  if((timer >= TIMER_COUNT) || Owner[timer]){
+    return 0;
+  }
+  Owner[timer] = owner ? owner : "?";
+  PLL_Register(&Retime);
+  if(Wide(timer)){
+    Clock_Acquire(CLOCK_WTIMER, timer-WTIMER_0);
+  } else{
+    Clock_Acquire(CLOCK_TIMER, timer);
+  }
+  Reset(timer, MODE_OFF);
+  return 1;
+}
+
+// ******** Timer_Close ************
+// stop a timer, disarm its interrupt, release it and gate its clock
+// Inputs: timer
+// Outputs: none
+void Timer_Close(uint32_t timer){
+  if((timer >= TIMER_COUNT) || (Owner[timer] == 0)){
+    return;
+  }
+  Reset(timer, MODE_OFF);
+  Owner[timer] = 0;
+  if(Wide(timer)){
+    Clock_Release(CLOCK_WTIMER, timer-WTIMER_0);
+  } else{
+    Clock_Release(CLOCK_TIMER, timer);
+  }
+}
+
+// ******** Timer_Owner ************
+// Inputs: timer
+// Outputs: name given to Timer_Open, 0 if the timer is free
+const char *Timer_Owner(uint32_t timer){
+  return (timer < TIMER_COUNT) ? Owner[timer] : 0;
+}
+
+// ******** Timer_OneShot ************
+// set up a one-shot timeout; Timer_Start runs it
+// Inputs: timer, NVIC priority 0 to 7, callback (0 for no interrupt)
+// Outputs: none
+void Timer_OneShot(uint32_t timer, uint32_t priority, Timer_Callback done){
+  uint32_t base = Base[timer];
+  Reset(timer, MODE_ONESHOT);
+  HWREG(base+CFG) = CFG_FULL;
+  HWREG(base+TAMR) = TAMR_1SHOT;
+  HWREG(base+TBILR) = 0;        // upper half of a wide timer's 64 bits
+  Callback[timer] = done;
+  if(done){
+    HWREG(base+IMR) = INT_TATO;
+    IrqEnable(timer, priority);
+  }
+}
+
+// ******** Timer_Periodic ************
+// time out every period bus cycles, starting now
+// with no callback the interrupt stays off; the timeout can still
+// trigger the timer's uDMA channel or the ADC
+// Inputs: timer, period in bus cycles (2 or more), NVIC priority 0 to
+//         7, callback (may be 0)
+// Outputs: none
+void Timer_Periodic(uint32_t timer, uint32_t period, uint32_t priority,
+                    Timer_Callback task){
+  uint32_t base = Base[timer];
+  Reset(timer, MODE_PERIODIC);
+  HWREG(base+CFG) = CFG_FULL;
+  HWREG(base+TAMR) = TAMR_PERIOD;
+  HWREG(base+TBILR) = 0;
+  Callback[timer] = task;
+  if(task){
+    HWREG(base+IMR) = INT_TATO;
+    IrqEnable(timer, priority);
+  }
+  Timer_Start(timer, period);
+}
+
+// ******** Timer_Capture ************
+// timestamp edges on the timer's CCP pin, starting now
+// timestamps count up at the bus clock and wrap at the width (see
+// Timer_Mask), so (now - then)&Timer_Mask(timer) is an interval
+// Inputs: timer, TIMER_RISING, TIMER_FALLING or TIMER_BOTH, NVIC
+//         priority 0 to 7, callback getting each timestamp
+// Outputs: none
+void Timer_Capture(uint32_t timer, uint32_t edge, uint32_t priority,
+                   Timer_Callback edgeTask){
+  uint32_t base = Base[timer];
+  Reset(timer, MODE_CAPTURE);
+  HWREG(base+CFG) = CFG_SPLIT;
+  HWREG(base+TAMR) = TAMR_CAP|TAMR_TACMR;  // edge time, counting down
+  Split(timer, TAILR, TAPR, Timer_Mask(timer)); // free running, full width
+  HWREG(base+CTL) = CTL_TAEVENT(edge);
+  Captured[timer] = 0;
+  Captured64[timer] = 0;
+  Wraps[timer] = 0;
+  Callback[timer] = edgeTask;
+  HWREG(base+IMR) = INT_CAE|INT_TATO;  // edges, and wraps to extend them
+  IrqEnable(timer, priority);
+  HWREG(base+CTL) = CTL_TAEVENT(edge)|CTL_TAEN;
+}
+
+// ******** Timer_EdgeCount ************
+// count edges on the timer's CCP pin; Timer_Read gets the count, which
+// wraps at 32 bits on either width
+// the counter stops when it reaches the width, and its interrupt
+// restarts it; edges in the few cycles that takes are not counted
+// Inputs: timer, edge, NVIC priority 0 to 7 of that interrupt
+// Outputs: none
+void Timer_EdgeCount(uint32_t timer, uint32_t edge, uint32_t priority){
+  uint32_t base = Base[timer];
+  Reset(timer, MODE_EDGECOUNT);
+  HWREG(base+CFG) = CFG_SPLIT;
+  HWREG(base+TAMR) = TAMR_CAP|TAMR_TACDIR; // edge count, counting up
+  Split(timer, TAILR, TAPR, Timer_Mask(timer));
+  Split(timer, TAMATCHR, TAPMR, Timer_Mask(timer)); // stops there
+  HWREG(base+CTL) = CTL_TAEVENT(edge);
+  Wraps[timer] = 0;
+  HWREG(base+IMR) = INT_CAM;
+  IrqEnable(timer, priority);
+  HWREG(base+CTL) = CTL_TAEVENT(edge)|CTL_TAEN;
+}
+
+// ******** Timer_PWM ************
+// PWM on the timer's CCP pin, starting now; period and duty changes
+// take effect at the next timeout, so a period is never cut short
+// Inputs: timer, period in bus cycles (2 to the width), high time in
+//         bus cycles (0 to period-1)
+// Outputs: none
+void Timer_PWM(uint32_t timer, uint32_t period, uint32_t high){
+  uint32_t base = Base[timer];
+  Reset(timer, MODE_PWM);
+  HWREG(base+CFG) = CFG_SPLIT;
+  HWREG(base+TAMR) = TAMR_PERIOD|TAMR_TAAMS|TAMR_TAILD|TAMR_TAMRSU;
+  Split(timer, TAILR, TAPR, period - 1);
+  Timer_SetDuty(timer, high);
+  HWREG(base+CTL) = CTL_TAEN;
+}
+
+// ******** Timer_SetDuty ************
+// new PWM high time, from the next period on
+// Inputs: timer, high time in bus cycles (0 to period-1)
+// Outputs: none
+void Timer_SetDuty(uint32_t timer, uint32_t high){
+  uint32_t load;
+  if(Wide(timer)){
+    load = HWREG(Base[timer]+TAILR);
+  } else{
+    load = (HWREG(Base[timer]+TAPR)<<16)|HWREG(Base[timer]+TAILR);
+  }
+  // the output goes high at the reload and low at the match
+  Split(timer, TAMATCHR, TAPMR, load - high);
+}
+
+// ******** Timer_TriggerADC ************
+// let the timeouts start ADC conversions (sequencers set to the timer
+// trigger), or stop them
+// Inputs: timer, 1 to trigger, 0 not to
+// Outputs: none
+void Timer_TriggerADC(uint32_t timer, int on){
+  if(on){
+    HWREG(Base[timer]+CTL) |= CTL_TAOTE;
+  } else{
+    HWREG(Base[timer]+CTL) &= ~CTL_TAOTE;
+  }
+}
+
+// ******** Timer_Start ************
+// (re)load and start; restarts a one-shot or changes a periodic rate
+// a timeout nobody has handled yet is forgotten
+// Inputs: timer, count in bus cycles (2 or more)
+// Outputs: none
+void Timer_Start(uint32_t timer, uint32_t count){
+  uint32_t base = Base[timer];
+  uint32_t irq = Irq[timer];
+  uint32_t ote = HWREG(base+CTL)&CTL_TAOTE;
+  HWREG(base+CTL) = ote;
+  HWREG(base+ICR) = INT_TATO;
+  HWREG(NVIC_UNPEND_BASE + 4*(irq/32)) = 1u<<(irq%32);
+  HWREG(base+TAILR) = count - 1;
+  HWREG(base+CTL) = ote|CTL_TAEN;
+}
+
+// ******** Timer_Stop ************
+// Inputs: timer
+// Outputs: none
+void Timer_Stop(uint32_t timer){
+  HWREG(Base[timer]+CTL) &= ~CTL_TAEN;
+}
+
+// ******** Timer_Read ************
+// Inputs: timer
+// Outputs: edge count, the latest capture timestamp, or the current
+//          down count in the other modes
+uint32_t Timer_Read(uint32_t timer){
+  if(Mode[timer] == MODE_CAPTURE){
+    return Captured[timer];
+  }
+  if(Mode[timer] == MODE_EDGECOUNT){
+    uint32_t mask = Timer_Mask(timer);
+    uint32_t sr = StartCritical();
+    uint32_t count = Wraps[timer]*mask + (HWREG(Base[timer]+TAR)&mask);
+    EndCritical(sr);            // stopped at the match until restarted,
+    return count;               // so either way the sum is the same
+  }
+  return HWREG(Base[timer]+TAR);
+}
+
+// ******** Timer_Read64 ************
+// Inputs: timer in capture mode
+// Outputs: latest capture timestamp extended to 64 bits with the count
+//          of wrap-arounds
+uint64_t Timer_Read64(uint32_t timer){
+  uint32_t sr = StartCritical();
+  uint64_t stamp = Captured64[timer];
+  EndCritical(sr);
+  return stamp;
+}
+
+// ******** Timer_Now64 ************
+// Inputs: timer in capture mode
+// Outputs: current time on the timestamp scale of Timer_Read64
+uint64_t Timer_Now64(uint32_t timer){
+  uint32_t base = Base[timer];
+  uint32_t mask = Timer_Mask(timer);
+  uint32_t sr = StartCritical();
+  uint64_t wraps = Wraps[timer];
+  uint32_t now = mask - (HWREG(base+TAV)&mask);
+  if((HWREG(base+RIS)&INT_TATO) && (now <= mask/2)){
+    wraps++;                    // wrapped, the interrupt hasn't run yet
+  }
+  EndCritical(sr);
+  return wraps*((uint64_t)mask + 1) + now;
+}
+
+// ******** Timer_Expired ************
+// Inputs: timer
+// Outputs: 1 if the timeout happened and its interrupt isn't handled
+uint32_t Timer_Expired(uint32_t timer){
+  return HWREG(Base[timer]+RIS)&INT_TATO;
+}
+
+// acknowledge, then hand the timestamp or the status to the owner
+static void Dispatch(uint32_t timer){
+  uint32_t base = Base[timer];
+  uint32_t status = HWREG(base+MIS);
+  uint32_t value = status;
+  HWREG(base+ICR) = status;
+  if(Mode[timer] == MODE_EDGECOUNT){
+    if(status&INT_CAM){         // stopped at the full width: restart
+      Wraps[timer]++;
+      HWREG(base+TAV) = 0;
+      HWREG(base+CTL) |= CTL_TAEN;
+    }
+    return;                     // nothing for the owner
+  }
+  if(Mode[timer] == MODE_CAPTURE){
+    uint32_t mask = Timer_Mask(timer);
+    uint32_t wraps;
+    if(status&INT_TATO){
+      Wraps[timer]++;
+    }
+    if((status&INT_CAE) == 0){
+      return;                   // only a wrap, nothing for the owner
+    }
+    // the capture register counts down; turn it into an up count
+    value = mask - (HWREG(base+TAR)&mask);
+    wraps = Wraps[timer];
+    if((status&INT_TATO) && (value > mask/2)){
+      wraps--;                  // the edge came just before the wrap
+    }
+    Captured[timer] = value;
+    Captured64[timer] = wraps*((uint64_t)mask + 1) + value;
+  }
+  if(Callback[timer]){
+    Callback[timer](timer, value);
+  }
+}
+
+void Timer0A_Handler(void){ Dispatch(TIMER_0); }
+void Timer1A_Handler(void){ Dispatch(TIMER_1); }
+void Timer2A_Handler(void){ Dispatch(TIMER_2); }
+void Timer3A_Handler(void){ Dispatch(TIMER_3); }
+void Timer4A_Handler(void){ Dispatch(TIMER_4); }
+void Timer5A_Handler(void){ Dispatch(TIMER_5); }
+void WideTimer0A_Handler(void){ Dispatch(WTIMER_0); }
+void WideTimer1A_Handler(void){ Dispatch(WTIMER_1); }
+void WideTimer2A_Handler(void){ Dispatch(WTIMER_2); }
+void WideTimer3A_Handler(void){ Dispatch(WTIMER_3); }
+void WideTimer4A_Handler(void){ Dispatch(WTIMER_4); }
+void WideTimer5A_Handler(void){ Dispatch(WTIMER_5); }
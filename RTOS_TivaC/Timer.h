@@ -0,0 +1,162 @@
+// Timer.h
+// Runs on TM4C123
+// General-purpose timer driver for the 6 standard (Timer0-5) and 6 wide
+// (WTimer0-5) timers, timer A of each.  One table of base addresses and
+// IRQ numbers drives every mode, and one interrupt handler per timer
+// acknowledges the interrupt and calls the callback its owner
+// registered, so a new periodic or capture source is a Timer_Open and
+// one setup call.
+// Widths: one-shot and periodic counts are 32 bits.  Capture, edge
+// count and PWM use the split timer A, 24 bits on a standard timer (16
+// plus the 8-bit prescaler) and 32 bits on a wide one.
+// Capture and PWM pins are muxed by the caller (GPIO AFSEL/PCTL).
+// Counts are bus cycles.  When PLL_SetFrequency changes the bus clock,
+// running one-shot and periodic counts are rescaled so they keep their
+// time; counts passed in afterwards are in cycles of the new clock.
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include <stdint.h>
+
+// timer numbers
+#define TIMER_0      0
+#define TIMER_1      1
+#define TIMER_2      2
+#define TIMER_3      3
+#define TIMER_4      4
+#define TIMER_5      5
+#define WTIMER_0     6
+#define WTIMER_1     7
+#define WTIMER_2     8
+#define WTIMER_3     9
+#define WTIMER_4     10
+#define WTIMER_5     11
+#define TIMER_COUNT  12
+
+// edges for capture and edge count (GPTMCTL TAEVENT)
+#define TIMER_RISING   0
+#define TIMER_FALLING  1
+#define TIMER_BOTH     3
+
+// called from the timer's interrupt handler
+// timer: TIMER_0 to WTIMER_5; value: the capture timestamp in capture
+// mode, otherwise the masked interrupt status that was acknowledged
+typedef void (*Timer_Callback)(uint32_t timer, uint32_t value);
+
+// ******** Timer_Open ************
+// claim a timer and turn its clock on
+// Inputs: timer, name of the owner (kept, for Timer_Owner)
+// Outputs: 1 if claimed, 0 if someone else owns it
+int Timer_Open(uint32_t timer, const char *owner);
+
+// ******** Timer_Close ************
+// stop a timer, disarm its interrupt, release it and gate its clock
+// Inputs: timer
+// Outputs: none
+void Timer_Close(uint32_t timer);
+
+// ******** Timer_Owner ************
+// Inputs: timer
+// Outputs: name given to Timer_Open, 0 if the timer is free
+const char *Timer_Owner(uint32_t timer);
+
+// ******** Timer_OneShot ************
+// set up a one-shot timeout; Timer_Start runs it
+// Inputs: timer, NVIC priority 0 to 7, callback (0 for no interrupt)
+// Outputs: none
+void Timer_OneShot(uint32_t timer, uint32_t priority, Timer_Callback done);
+
+// ******** Timer_Periodic ************
+// time out every period bus cycles, starting now
+// with no callback the interrupt stays off; the timeout can still
+// trigger the timer's uDMA channel or the ADC
+// Inputs: timer, period in bus cycles (2 or more), NVIC priority 0 to
+//         7, callback (may be 0)
+// Outputs: none
+void Timer_Periodic(uint32_t timer, uint32_t period, uint32_t priority,
+                    Timer_Callback task);
+
+// ******** Timer_Capture ************
+// timestamp edges on the timer's CCP pin, starting now
+// timestamps count up at the bus clock and wrap at the width (see
+// Timer_Mask), so (now - then)&Timer_Mask(timer) is an interval;
+// Timer_Read64 extends them with the count of wrap-arounds, which the
+// timeout interrupt keeps, so intervals of any length come out right
+// Inputs: timer, TIMER_RISING, TIMER_FALLING or TIMER_BOTH, NVIC
+//         priority 0 to 7, callback getting each timestamp
+// Outputs: none
+void Timer_Capture(uint32_t timer, uint32_t edge, uint32_t priority,
+                   Timer_Callback edgeTask);
+
+// ******** Timer_EdgeCount ************
+// count edges on the timer's CCP pin; Timer_Read gets the count, which
+// wraps at 32 bits on either width
+// the counter stops when it reaches the width, and its interrupt
+// restarts it; edges in the few cycles that takes are not counted
+// Inputs: timer, edge, NVIC priority 0 to 7 of that interrupt
+// Outputs: none
+void Timer_EdgeCount(uint32_t timer, uint32_t edge, uint32_t priority);
+
+// ******** Timer_PWM ************
+// PWM on the timer's CCP pin, starting now; period and duty changes
+// take effect at the next timeout, so a period is never cut short
+// Inputs: timer, period in bus cycles (2 to the width), high time in
+//         bus cycles (0 to period-1)
+// Outputs: none
+void Timer_PWM(uint32_t timer, uint32_t period, uint32_t high);
+
+// ******** Timer_SetDuty ************
+// new PWM high time, from the next period on
+// Inputs: timer, high time in bus cycles (0 to period-1)
+// Outputs: none
+void Timer_SetDuty(uint32_t timer, uint32_t high);
+
+// ******** Timer_TriggerADC ************
+// let the timeouts start ADC conversions (sequencers set to the timer
+// trigger), or stop them
+// Inputs: timer, 1 to trigger, 0 not to
+// Outputs: none
+void Timer_TriggerADC(uint32_t timer, int on);
+
+// ******** Timer_Start ************
+// (re)load and start; restarts a one-shot or changes a periodic rate
+// a timeout nobody has handled yet is forgotten
+// Inputs: timer, count in bus cycles (2 or more)
+// Outputs: none
+void Timer_Start(uint32_t timer, uint32_t count);
+
+// ******** Timer_Stop ************
+// Inputs: timer
+// Outputs: none
+void Timer_Stop(uint32_t timer);
+
+// ******** Timer_Read ************
+// Inputs: timer
+// Outputs: edge count, the latest capture timestamp, or the current
+//          down count in the other modes
+uint32_t Timer_Read(uint32_t timer);
+
+// ******** Timer_Read64 ************
+// Inputs: timer in capture mode
+// Outputs: latest capture timestamp extended to 64 bits with the count
+//          of wrap-arounds
+uint64_t Timer_Read64(uint32_t timer);
+
+// ******** Timer_Now64 ************
+// Inputs: timer in capture mode
+// Outputs: current time on the timestamp scale of Timer_Read64
+uint64_t Timer_Now64(uint32_t timer);
+
+// ******** Timer_Expired ************
+// Inputs: timer
+// Outputs: 1 if the timeout happened and its interrupt isn't handled
+uint32_t Timer_Expired(uint32_t timer);
+
+// ******** Timer_Mask ************
+// Inputs: timer
+// Outputs: largest capture timestamp, 0x00FFFFFF on a standard timer,
+//          0xFFFFFFFF on a wide one
+uint32_t Timer_Mask(uint32_t timer);
+
+#endif
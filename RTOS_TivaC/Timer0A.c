@@ -1,67 +1,132 @@
-// Timer0A.c
-// Runs on Tiva-C
-
-// Adapted from SysTick.c from the book:
-/* "Embedded Systems: Introduction to MSP432 Microcontrollers",
-   ISBN: 978-1469998749, Jonathan Valvano, copyright (c) 2015
-   Volume 1, Program 4.7
-*/
-
-#include <stdint.h>
-#include "tm4c123gh6pm.h"
-#include "Timer0A.h"
-
-uint32_t sysClkFreq = 80000000; // Assume 80 MHz clock by default
-
-// Set clock freq. so Timer0A_Wait10ms delays for exactly 10 ms if clock is not 80 MHz
-void Timer0A_Init( uint32_t clkFreq ){
-  sysClkFreq = clkFreq;
-
-  SYSCTL_RCGCTIMER_R |= 0x00000001;  // 0) Activate Timer0
-  TIMER0_CTL_R &= ~0x00000001;       // 1) Disable Timer0A during setup
-  TIMER0_CFG_R = 0;                  // 2) Configure for 32-bit timer mode
-  TIMER0_TAMR_R = 0;                 // 3) Configure for one-shot mode
-  TIMER0_TAILR_R = sysClkFreq;        // 4) Specify reload value
-  TIMER0_TAPR_R = 0;                 // 5) No prescale
-  TIMER0_IMR_R = 0;                  // 6-9) No interrupts
-  TIMER0_CTL_R |= 0x00000001;        // 10) Enable Timer0A
-
-  return;
-}
-
-// Time delay using busy wait
-// The delay parameter is in units of the core clock (units of 12.5 nsec for 80 MHz clock)
-//   Adapted from Program 9.8 from the book:
-/*   "Embedded Systems: Introduction to ARM Cortex-M Microcontrollers",
-     ISBN: 978-1477508992, Jonathan Valvano, copyright (c) 2013
-     Volume 1, Program 9.8
-*/
-void Timer0A_Wait( uint32_t delay ){
-
-  if(delay <= 1){ return; } // Immediately return if requested delay less than one clock
-
-  SYSCTL_RCGCTIMER_R |= 0x00000001;  // 0) Activate Timer0
-  TIMER0_CTL_R &= ~0x00000001;       // 1) Disable Timer0A during setup
-  TIMER0_CFG_R = 0;                  // 2) Configure for 32-bit timer mode
-  TIMER0_TAMR_R = 1;                 // 3) Configure for one-shot mode
-  TIMER0_TAILR_R = delay - 1;        // 4) Specify reload value
-  TIMER0_TAPR_R = 0;                 // 5) No prescale
-  TIMER0_IMR_R = 0;                  // 6-9) No interrupts
-  TIMER0_CTL_R |= 0x00000001;        // 10) Enable Timer0A
-
-  //while( TIMER0_TAR_R ){} // Doesn't work; Wait until timer expires (value equals 0)
-  // Or, clear interrupt and wait for raw interrupt flag to be set
-  TIMER0_ICR_R = 1;
-  while( !(TIMER0_RIS_R & 0x1) ){}
-  return;
-}
-
-// Time delay using busy wait
-// This assumes 80 MHz system clock
-void Timer0A_Wait1ms( uint32_t delay ){
-  uint32_t i;
-  for( i = 0; i < delay; i++ ){
-    Timer0A_Wait(sysClkFreq/1000);  // wait 1ms
-  }
-  return;
-}
+// Timer0A.c
+// Runs on Tiva-C
+// One-shot delay service with bus-clock resolution.  Timer0A is set up
+// once; each delay only loads the count and starts it, and the timeout
+// interrupt (IRQ 19) ends the wait.  A thread blocks on a semaphore
+// meanwhile, so the others run; with no kernel running the CPU sleeps
+// in WFI; in an ISR or with interrupts disabled it polls the flag.
+
+// Adapted from SysTick.c from the book:
+/* "Embedded Systems: Introduction to MSP432 Microcontrollers",
+   ISBN: 978-1469998749, Jonathan Valvano, copyright (c) 2015
+   Volume 1, Program 4.7
+*/
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "Timer.h"
+#include "Timer0A.h"
+#include "PLL.h"
+#include "os.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+void WaitForInterrupt(void);     // low power mode
+
+#define TIMER0_PRI  4           // Timer0A interrupt priority
+#define MAXCHUNK_US 1000000     // longest single count, fits 32 bits to 4 GHz
+
+static uint32_t BusHz;          // bus clock the delays scale to
+
+static volatile uint8_t Expired;// set by the timeout interrupt
+static volatile uint8_t Blocked;// a thread waits on Timer0ADone
+int32_t Timer0AFree = 1;        // threads take turns with the timer
+int32_t Timer0ADone = 0;        // signaled when their delay is over
+
+static void Timeout( uint32_t timer, uint32_t status );
+
+// new bus clock, called by PLL_SetFrequency; the Timer driver rescales
+// a delay in progress
+static void Retime( uint32_t from, uint32_t to ){
+  BusHz = to;
+}
+
+// bus cycles in us microseconds; whole MHz or not (16.667, 66.667 MHz)
+static uint32_t Cycles( uint32_t us ){
+  return (uint32_t)((uint64_t)us*BusHz/1000000);
+}
+
+// Scale the delays to the bus clock in use
+void Timer0A_Init( void ){
+  BusHz = PLL_BusClock();
+  PLL_Register(&Retime);
+
+  Timer_Open(TIMER_0, "delay");
+  Timer_OneShot(TIMER_0, TIMER0_PRI, &Timeout);
+  Expired = 1;
+  Blocked = 0;
+
+  return;
+}
+
+// Timer0A timeout, acknowledged by the Timer driver
+static void Timeout( uint32_t timer, uint32_t status ){
+  Expired = 1;
+  if(Blocked){
+    Blocked = 0;
+    OS_Signal(&Timer0ADone);
+  }
+}
+
+// count delay bus cycles from now; the one-shot stops itself
+static void Start( uint32_t delay ){
+  Expired = 0;
+  Timer_Start(TIMER_0, delay);       // forgets a timeout nobody took
+}
+
+// Time delay of delay bus cycles (units of 125 ns for the 8 MHz clock)
+void Timer0A_Wait( uint32_t delay ){
+  uint32_t sr;
+
+  if(delay <= 1){ return; } // Immediately return if requested delay less than one clock
+
+  sr = StartCritical();
+  EndCritical(sr);
+  if(sr || (NVIC_INT_CTRL_R&NVIC_INT_CTRL_VEC_ACT_M)){
+    Start(delay);                    // ISR or interrupts off: poll
+    while(!Expired && !Timer_Expired(TIMER_0)){}
+    Expired = 1;
+    if(Blocked){                     // took the timer from a thread,
+      Blocked = 0;                   // whose delay ends early
+      OS_Signal(&Timer0ADone);
+    }
+  } else if(OS_Running()){
+    OS_Wait(&Timer0AFree);
+    sr = StartCritical();
+    Blocked = 1;
+    Start(delay);
+    EndCritical(sr);
+    OS_Wait(&Timer0ADone);           // other threads run meanwhile
+    OS_Signal(&Timer0AFree);
+  } else{
+    sr = StartCritical();            // no other thread to run
+    Start(delay);
+    while(!Expired){
+      WaitForInterrupt();            // wakes on the pending interrupt
+      EndCritical(sr);               // let it run
+      sr = StartCritical();
+    }
+    EndCritical(sr);
+  }
+  return;
+}
+
+// Time delay in microseconds
+void Timer0A_WaitUs( uint32_t delay ){
+  while(delay > MAXCHUNK_US){
+    Timer0A_Wait(Cycles(MAXCHUNK_US));
+    delay -= MAXCHUNK_US;
+  }
+  Timer0A_Wait(Cycles(delay));
+  return;
+}
+
+// Time delay in milliseconds
+void Timer0A_Wait1ms( uint32_t delay ){
+  while(delay > MAXCHUNK_US/1000){
+    Timer0A_WaitUs(MAXCHUNK_US);
+    delay -= MAXCHUNK_US/1000;
+  }
+  Timer0A_WaitUs(delay*1000);
+  return;
+}
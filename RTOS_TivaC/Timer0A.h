@@ -1,24 +1,34 @@
-// Timer0A.h
-// Runs on Tiva-C
-
-// Adapted from SysTick.h from the book:
-/* "Embedded Systems: Introduction to MSP432 Microcontrollers",
-   ISBN: 978-1469998749, Jonathan Valvano, copyright (c) 2015
-   Volume 1, Program 4.7
-*/
-
-#ifndef __TIMER0A_H__
-#define __TIMER0A_H__
-
-// Set clock freq. so Timer0A_Wait10ms delays for exactly 10 ms if clock is not 80 MHz
-void Timer0A_Init( uint32_t clkFreq );
-
-// Time delay using busy wait
-// The delay parameter is in units of the core clock (units of 12.5 nsec for 80 MHz clock)
-void Timer0A_Wait( uint32_t delay );
-
-// Time delay using busy wait
-// This assumes 80 MHz system clock
-void Timer0A_Wait1ms( uint32_t delay );
-
-#endif
+// Timer0A.h
+// Runs on Tiva-C
+// One-shot delay service on Timer0A (IRQ 19).  A thread calling these
+// blocks until the timeout interrupt wakes it and the other threads
+// run meanwhile; one thread at a time uses the timer, the others queue.
+// Without the kernel the CPU sleeps until the timeout; in an ISR or with
+// interrupts disabled the wait polls (and cuts short a thread's delay
+// that is in progress, so keep those waits out of ISRs when threads
+// use the timer).
+
+// Adapted from SysTick.h from the book:
+/* "Embedded Systems: Introduction to MSP432 Microcontrollers",
+   ISBN: 978-1469998749, Jonathan Valvano, copyright (c) 2015
+   Volume 1, Program 4.7
+*/
+
+#ifndef __TIMER0A_H__
+#define __TIMER0A_H__
+
+// Scale the delays to the bus clock in use (PLL_BusClock); call after
+// PLL_Init and before enabling interrupts
+void Timer0A_Init( void );
+
+// Time delay
+// The delay parameter is in units of the bus clock (units of 125 nsec for 8 MHz clock)
+void Timer0A_Wait( uint32_t delay );
+
+// Time delay in microseconds
+void Timer0A_WaitUs( uint32_t delay );
+
+// Time delay in milliseconds
+void Timer0A_Wait1ms( uint32_t delay );
+
+#endif
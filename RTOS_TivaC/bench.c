@@ -0,0 +1,340 @@
+//*****************************************************************************
+// bench.c
+// Runs on TM4C123 or the QEMU mps2-an386 machine
+// Kernel benchmark program, built instead of user.c's main when
+// RTOS_BENCH is defined (qemu/Makefile, or a CCS build configuration
+// with --define=RTOS_BENCH for the LaunchPad).
+// Uses the real OSasm.asm and os.c; all board access goes through BSP.h.
+// Counts are bus cycles on the LaunchPad (DWT_CYCCNT) and instructions
+// on QEMU, so compare a build only against the same board.
+//
+// Report, one "name count" pair per line, averaged per operation:
+//   rtos_bench 1      format version, bump when a line changes meaning
+//   switch            SysTick context switch, thread to thread
+//   yield             OS_Suspend, thread to thread
+//   sem_pingpong      OS_Signal + OS_Wait handing control to the other thread
+//   fifo_put          OS_FIFO_Put, no thread waiting
+//   fifo_get          OS_FIFO_Get, data available
+//   fifo_handoff      OS_FIFO_Put to a blocked OS_FIFO_Get returning
+//   isr_wake          interrupt trigger to the signaled thread running
+//   tick              kernel tick: timer ISR, sleep countdown, event thread
+//   idle_sleeps       times the idle thread slept over SLEEPROUNDS OS_Sleep(1)
+//                     calls with every other thread asleep, a total
+//   idle_sleep        bus cycles per idle sleep (OS_SleepCycles/OS_Sleeps)
+//   idle_sleep_pct    of the time those calls took, percent spent asleep
+//   deep_sleeps       deep sleeps over DEEPROUNDS OS_Sleep(EVENTMS) calls
+//                     with every other thread asleep, a total (0 on QEMU,
+//                     which has no deep sleep)
+//   deep_sleep        bus cycles per deep sleep
+//   fir_c             16-tap Q15 FIR over a 64-sample block, plain C loop
+//   fir_simd          the same block through DSP_FIR (SMLALD, two taps each)
+//   end 0             all tests ran
+// On the LaunchPad the capture interrupt and the display uDMA set up by
+// BSP_Init keep running, so expect a little more jitter there than on QEMU.
+// The display stays blank and the motor stopped, so in the deep sleep
+// test those drivers park their peripherals (BSP_DeepClient) and the
+// idle thread can sleep deep.
+
+#ifdef RTOS_BENCH
+
+#include <stdint.h>
+#include "os.h"
+#include "BSP.h"
+#include "Format.h"
+#include "DSP.h"
+#include "tm4c123gh6pm.h"
+
+#define ROUNDS        1000   // repetitions of each test
+#define FIFOBATCH     8      // puts before the gets, less than the FIFO size
+#define TICKROUNDS    100    // kernel ticks to average
+#define EVENTMS       10     // period of the event thread, ms (kernel ticks)
+#define SLEEPROUNDS   100    // OS_Sleep(1) calls with the idle thread running
+#define DEEPROUNDS    20     // OS_Sleep(EVENTMS) calls, deep sleep allowed
+#define BENCHSLICE    0x00FFFFFF // longest slice, so only forced switches occur
+#define WAKEIRQ       27     // unused on both boards (TM4C123 analog comparator 2)
+#define DSPROUNDS     100    // blocks through each FIR
+#define FIRTAPS       16
+
+// test selector for the partner thread
+#define T_NONE        0
+#define T_SWITCH      1
+#define T_YIELD       2
+#define T_SEMA        3
+#define T_FIFO        4
+#define T_ISR         5
+#define T_SLEEP       6
+
+volatile uint32_t Test;      // which test the partner is running
+int32_t Go;                  // controller -> partner, start the test in Test
+int32_t Ping, Pong;          // semaphore ping-pong
+int32_t WakeSema;            // signaled by the wake-up interrupt
+volatile uint32_t WakeStart; // cycle count when the interrupt was triggered
+uint32_t WakeTotal;          // sum of interrupt-to-thread latencies
+volatile uint32_t EventCount;// runs of the periodic event thread
+
+// one "name count" line of the report
+static void Report(const char *name, uint32_t count){
+  char buf[FMT_BUFSIZE];
+  Fmt_UDec(buf, count);
+  BSP_OutString(name);
+  BSP_OutChar(' ');
+  BSP_OutString(buf);
+  BSP_OutChar('\n');
+}
+
+// FIR test data: a 16-tap low-pass and a block with history in front
+static const int16_t FirH[FIRTAPS] = {
+  -120, -310, -380, 0, 1180, 3010, 4900, 6020,
+  6020, 4900, 3010, 1180, 0, -380, -310, -120
+};
+int16_t FirIn[FIRTAPS-1+DSP_BLOCKMAX], FirOut[DSP_BLOCKMAX];
+struct DSP_FIR Fir;
+
+// the FIR as it would be written without the DSP library
+static void NaiveFIR(void){
+  uint32_t n, k;
+  int32_t acc;
+  for(n = 0; n < DSP_BLOCKMAX; n++){
+    acc = 0;
+    for(k = 0; k < FIRTAPS; k++){
+      acc += FirH[k]*FirIn[FIRTAPS-1+n-k];
+    }
+    FirOut[n] = (int16_t)(acc>>15);
+  }
+}
+
+// software-triggered interrupt, stands in for a device ISR
+void Comp2_Handler(void){
+  OS_Signal(&WakeSema);
+  OS_Suspend();              // switch as soon as the ISR returns
+}
+
+// runs every EVENTMS kernel ticks, all through the tests
+void TickEvent(void){
+  EventCount++;
+}
+
+// start a test on the partner thread and let it block on its semaphore
+static void Start(uint32_t test){
+  Test = test;
+  OS_Signal(&Go);
+  OS_Suspend();              // partner runs until it blocks in its test
+}
+
+// Thread 1, the other side of every two-thread test.  It blocks on Go
+// between tests, so the controller only ever waits on a ready partner.
+void Partner(void){
+  for(;;){
+    OS_Wait(&Go);
+    switch(Test){
+      case T_SWITCH:
+        while(Test == T_SWITCH){
+          NVIC_INT_CTRL_R = NVIC_INT_CTRL_PENDSTSET;
+        }
+        break;
+      case T_YIELD:
+        while(Test == T_YIELD){
+          OS_Suspend();
+        }
+        break;
+      case T_SEMA:
+        for(;;){
+          OS_Wait(&Ping);
+          if(Test != T_SEMA) break;
+          OS_Signal(&Pong);
+        }
+        break;
+      case T_FIFO:
+        while(OS_FIFO_Get()){}  // 0 ends the test
+        break;
+      case T_ISR:
+        for(;;){
+          OS_Wait(&WakeSema);
+          if(Test != T_ISR) break;
+          WakeTotal += BSP_Cycles() - WakeStart;
+        }
+        break;
+      case T_SLEEP:
+        OS_Sleep(0xFFFFFFFF);   // keeps the tick counting it down
+        break;
+    }
+  }
+}
+
+// Thread 0, runs the tests in order and prints the report
+void Controller(void){
+  uint32_t i, j, start, now, prev, total, gets, n, e, events, gap;
+  uint32_t sleeps, slept;
+
+  BSP_OutString("rtos_bench 1\n");
+
+  // SysTick switch: each pend switches to the other thread, which pends back
+  Start(T_SWITCH);
+  start = BSP_Cycles();
+  for(i = 0; i < ROUNDS; i++){
+    NVIC_INT_CTRL_R = NVIC_INT_CTRL_PENDSTSET;
+  }
+  total = BSP_Cycles() - start;
+  Test = T_NONE;
+  NVIC_INT_CTRL_R = NVIC_INT_CTRL_PENDSTSET; // partner sees T_NONE, blocks
+  Report("switch", total/(2*ROUNDS));
+
+  // same with OS_Suspend
+  Start(T_YIELD);
+  start = BSP_Cycles();
+  for(i = 0; i < ROUNDS; i++){
+    OS_Suspend();
+  }
+  total = BSP_Cycles() - start;
+  Test = T_NONE;
+  OS_Suspend();
+  Report("yield", total/(2*ROUNDS));
+
+  // semaphore ping-pong, two hand-offs per round
+  OS_InitSemaphore(&Ping, 0);
+  OS_InitSemaphore(&Pong, 0);
+  Start(T_SEMA);               // partner blocks on Ping
+  start = BSP_Cycles();
+  for(i = 0; i < ROUNDS; i++){
+    OS_Signal(&Ping);
+    OS_Wait(&Pong);
+  }
+  total = BSP_Cycles() - start;
+  Test = T_NONE;
+  OS_Signal(&Ping);
+  OS_Suspend();
+  Report("sem_pingpong", total/(2*ROUNDS));
+
+  // FIFO without blocking: the partner is not waiting yet
+  OS_FIFO_Init();
+  total = 0;
+  gets = 0;
+  for(i = 0; i < ROUNDS/FIFOBATCH; i++){
+    start = BSP_Cycles();
+    for(j = 0; j < FIFOBATCH; j++){
+      OS_FIFO_Put(j+1);
+    }
+    now = BSP_Cycles();
+    total += now - start;
+    for(j = 0; j < FIFOBATCH; j++){
+      OS_FIFO_Get();
+    }
+    gets += BSP_Cycles() - now;
+  }
+  Report("fifo_put", total/((ROUNDS/FIFOBATCH)*FIFOBATCH));
+  Report("fifo_get", gets/((ROUNDS/FIFOBATCH)*FIFOBATCH));
+
+  // FIFO hand-off: put wakes the blocked partner, which gets and blocks again
+  Start(T_FIFO);
+  start = BSP_Cycles();
+  for(i = 0; i < ROUNDS; i++){
+    OS_FIFO_Put(i+1);
+    OS_Suspend();
+  }
+  total = BSP_Cycles() - start;
+  OS_FIFO_Put(0);
+  OS_Suspend();
+  Report("fifo_handoff", total/ROUNDS);
+
+  // interrupt to thread: trigger, ISR signals and suspends, partner runs
+  OS_InitSemaphore(&WakeSema, 0);
+  WakeTotal = 0;
+  NVIC_PRI6_R = (NVIC_PRI6_R&0x00FFFFFF)|0xA0000000; // IRQ 27 priority 5
+  NVIC_EN0_R = 1<<WAKEIRQ;
+  Start(T_ISR);
+  for(i = 0; i < ROUNDS; i++){
+    WakeStart = BSP_Cycles();
+    NVIC_SW_TRIG_R = WAKEIRQ;
+  }
+  NVIC_DIS0_R = 1<<WAKEIRQ;
+  Test = T_NONE;
+  OS_Signal(&WakeSema);
+  OS_Suspend();
+  Report("isr_wake", WakeTotal/ROUNDS);
+
+  // kernel tick: time stolen from a polling loop, with the partner
+  // asleep.  Only gaps in which the event thread ran count, so other
+  // interrupts and ticks without the event are left out; the tick may
+  // land after the EventCount read, then the previous gap is the one.
+  Start(T_SLEEP);
+  total = 0;
+  n = 0;
+  gap = 0;
+  events = EventCount;
+  prev = BSP_Cycles();
+  while(n < TICKROUNDS){
+    e = EventCount;
+    now = BSP_Cycles();
+    if(e != events){
+      events = e;
+      total += ((now - prev) > gap) ? (now - prev) : gap;
+      n++;
+    }
+    gap = now - prev;
+    prev = now;
+  }
+  Report("tick", total/TICKROUNDS);
+
+  // idle thread: the partner is still asleep, so each OS_Sleep leaves
+  // no thread ready and the idle thread sleeps until the next tick.
+  // One tick to the deadline is under DEEPMIN, so these are plain sleeps.
+  sleeps = OS_Sleeps();
+  slept = OS_SleepCycles();
+  start = BSP_Cycles();
+  for(i = 0; i < SLEEPROUNDS; i++){
+    OS_Sleep(1);
+  }
+  total = BSP_Cycles() - start;
+  sleeps = OS_Sleeps() - sleeps;
+  slept = OS_SleepCycles() - slept;
+  Report("idle_sleeps", sleeps);
+  Report("idle_sleep", sleeps ? slept/sleeps : 0);
+  Report("idle_sleep_pct", total ? (uint32_t)((uint64_t)slept*100/total) : 0);
+
+  // deep sleep: the same with the next deadline EVENTMS ticks off, far
+  // enough for the idle thread to sleep deep if the board lets it; the
+  // first may find the console still sending the lines above
+  sleeps = OS_DeepSleeps();
+  slept = OS_DeepSleepCycles();
+  for(i = 0; i < DEEPROUNDS; i++){
+    OS_Sleep(EVENTMS);
+  }
+  sleeps = OS_DeepSleeps() - sleeps;
+  slept = OS_DeepSleepCycles() - slept;
+  Report("deep_sleeps", sleeps);
+  Report("deep_sleep", sleeps ? slept/sleeps : 0);
+
+  // the same FIR block, plain C against the SIMD library
+  for(i = 0; i < FIRTAPS-1+DSP_BLOCKMAX; i++){
+    FirIn[i] = (int16_t)((i*7919)&0x7FFF) - 0x4000;
+  }
+  start = BSP_Cycles();
+  for(i = 0; i < DSPROUNDS; i++){
+    NaiveFIR();
+  }
+  total = BSP_Cycles() - start;
+  Report("fir_c", total/DSPROUNDS);
+  DSP_FIRInit(&Fir, FirH, FIRTAPS);
+  start = BSP_Cycles();
+  for(i = 0; i < DSPROUNDS; i++){
+    DSP_FIR(&Fir, &FirIn[FIRTAPS-1], FirOut, DSP_BLOCKMAX);
+  }
+  total = BSP_Cycles() - start;
+  Report("fir_simd", total/DSPROUNDS);
+
+  BSP_OutString("end 0\n");
+  BSP_Exit(0);
+}
+
+int main(void){
+  OS_Init();           // initialize, disable interrupts, board via BSP_Init
+  OS_InitSemaphore(&Go, 0);
+  OS_FIFO_Init();
+  OS_AddThread(&Controller);
+  OS_AddThread(&Partner);
+  OS_AddPeriodicEventThread(&TickEvent, EVENTMS);
+  OS_Launch(BENCHSLICE); // doesn't return, interrupts enabled in here
+  return 0;              // this never executes
+}
+
+#endif
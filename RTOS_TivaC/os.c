@@ -1,184 +1,490 @@
-// os.c
-// Runs on LM4F120/TM4C123
-// A very simple real time operating system with minimal features.
-// Daniel Valvano
-// January 29, 2015
-
-/* This example accompanies the book
-   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
-   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
-
-   Programs 4.4 through 4.12, section 4.2
-
- Copyright 2015 by Jonathan W. Valvano, valvano@mail.utexas.edu
-    You may use, edit, run or distribute this file
-    as long as the above copyright notice remains
- THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
- OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- For more information about my classes, my research, and my books, see
- http://users.ece.utexas.edu/~valvano/
- */
-
-#include <stdint.h>
-#include "os.h"
-#include "PLL.h"
-#include "SSI2.h"
-#include "LCD.h"
-#include "Timer0A.h"
-#include "Timer1A.h"
-#include "Timer2A.h"
-#include "Timer3A.h"
-#include "tm4c123gh6pm.h"
-
-volatile uint32_t Slicecount = 0;
-
-volatile uint32_t TIN = 0;
-
-// function definitions in OSasm.s
-void OS_DisableInterrupts(void); // Disable interrupts
-void OS_EnableInterrupts(void);  // Enable interrupts
-int32_t StartCritical(void);
-void EndCritical(int32_t primask);
-void StartOS(void);
-
-#define NUMTHREADS  3        // maximum number of threads
-#define STACKSIZE   100      // number of 32-bit words in stack
-struct tcb{
-  int32_t *sp;       // pointer to stack (valid for threads not running
-  struct tcb *next;  // linked-list pointer
-  uint32_t TIN;  // thread identification number
-};
-typedef struct tcb tcbType;
-tcbType tcbs[NUMTHREADS];
-tcbType *RunPt;
-int32_t Stacks[NUMTHREADS][STACKSIZE];
-
-// ******** OS_Init ************
-// initialize operating system, disable interrupts until OS_Launch
-// initialize OS controlled I/O: systick, 8 MHz PLL
-// Inputs: none
-// Outputs: none
-void OS_Init(void){
-  OS_DisableInterrupts();
-  PLL_Init(Bus8MHz);         // set processor clock to 8 MHz
-  NVIC_ST_CTRL_R = 0;         // disable SysTick during setup
-  NVIC_ST_CURRENT_R = 0;      // any write to current clears it
-  NVIC_SYS_PRI3_R =(NVIC_SYS_PRI3_R&0x00FFFFFF)|0xE0000000; // priority 7
-
-  // initialize Timer0A
-  Timer0A_Init(8000000); // 10 ms
-  
-  // initialize Timer1A 
-  Timer1A_Init(8000000); // 10 ms
-
-  // initialize Timer2A
-  Timer2A_Init(8000000); // 10 ms
-
-  // initialize SSI2
-  SSI2_init();
-
-  // initialize 7SDisplay
-  sevenseg_init();
-
-//  const static unsigned char digitPattern[] = {0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8, 0x80, 0x90};
-//
-//  SSI2_write(digitPattern[1], 0x80);
-//  SSI2_write(0x08, 0x80);
-//
-//  SSI2_write(digitPattern[2], 0x80);
-//  SSI2_write(0x04, 0x80);
-//
-//  SSI2_write(digitPattern[3], 0x80);
-//  SSI2_write(0x02, 0x80);
-//
-//  SSI2_write(digitPattern[4], 0x80);
-//  SSI2_write(0x01, 0x80);
-
-  // displayDigit(0, 0);
-
-}
-
-void SetInitialStack(int i){
-  tcbs[i].sp = &Stacks[i][STACKSIZE-16]; // thread stack pointer
-  Stacks[i][STACKSIZE-1] = 0x01000000;   // thumb bit
-  Stacks[i][STACKSIZE-3] = 0x14141414;   // R14
-  Stacks[i][STACKSIZE-4] = 0x12121212;   // R12
-  Stacks[i][STACKSIZE-5] = 0x03030303;   // R3
-  Stacks[i][STACKSIZE-6] = 0x02020202;   // R2
-  Stacks[i][STACKSIZE-7] = 0x01010101;   // R1
-  Stacks[i][STACKSIZE-8] = 0x00000000;   // R0
-  Stacks[i][STACKSIZE-9] = 0x11111111;   // R11
-  Stacks[i][STACKSIZE-10] = 0x10101010;  // R10
-  Stacks[i][STACKSIZE-11] = 0x09090909;  // R9
-  Stacks[i][STACKSIZE-12] = 0x08080808;  // R8
-  Stacks[i][STACKSIZE-13] = 0x07070707;  // R7
-  Stacks[i][STACKSIZE-14] = 0x06060606;  // R6
-  Stacks[i][STACKSIZE-15] = 0x05050505;  // R5
-  Stacks[i][STACKSIZE-16] = 0x04040404;  // R4
-}
-
-
-// ******** OS_AddThread ***************
-// add three foreground threads to the scheduler
-// Inputs: three pointers to a void/void foreground tasks
-// Outputs: 1 if successful, 0 if this thread can not be added
-int OS_AddThreads(void(*task0)(void),
-                 void(*task1)(void),
-                 void(*task2)(void)){ int32_t status;
-  status = StartCritical();
-  tcbs[0].next = &tcbs[1]; // 0 points to 1
-  tcbs[1].next = &tcbs[2]; // 1 points to 2
-  tcbs[2].next = &tcbs[0]; // 2 points to 0
-  SetInitialStack(0); Stacks[0][STACKSIZE-2] = (int32_t)(task0); // PC
-  SetInitialStack(1); Stacks[1][STACKSIZE-2] = (int32_t)(task1); // PC
-  SetInitialStack(2); Stacks[2][STACKSIZE-2] = (int32_t)(task2); // PC
-  RunPt = &tcbs[0];       // thread 0 will run first
-
-  tcbs[0].TIN = 0;
-  tcbs[1].TIN = 1;
-  tcbs[2].TIN = 2;
-  
-  EndCritical(status);
-  return 1;               // successful
-}
-
-/// ******** OS_Launch ***************
-// start the scheduler, enable interrupts
-// Inputs: number of bus clock cycles for each time slice
-//         (maximum of 24 bits)
-// Outputs: none (does not return)
-void OS_Launch(uint32_t theTimeSlice){
-  NVIC_ST_RELOAD_R = theTimeSlice - 1; // reload value
-  NVIC_ST_CTRL_R = 0x00000007; // enable, core clock and interrupt arm
-  StartOS();                   // start on the first task
-}
-
-// enable SSI2 and associated GPIO pins
-void sevenseg_init(void)
-{
-  SYSCTL_RCGCGPIO_R |= 0x02; // enable clock to GPIOB
-  SYSCTL_RCGCGPIO_R |= 0x04; // enable clock to GPIOC
-  SYSCTL_RCGCSSI_R |= 0x04;  // enable clock to SSI2
-
-  // PORTB 7, 4 for SSI2 TX and SCLK
-  GPIO_PORTB_AMSEL_R &= ~0x90;      // turn off analog of PORTB 7, 4
-  GPIO_PORTB_AFSEL_R |= 0x90;       // PORTB 7, 4 for alternate function
-  GPIO_PORTB_PCTL_R &= ~0xF00F0000; // clear functions for PORTB 7, 4
-  GPIO_PORTB_PCTL_R |= 0x20020000;  // PORTB 7, 4 for SSI2 function
-  GPIO_PORTB_DEN_R |= 0x90;         // PORTB 7, 4 as digital pins
-
-  // PORTC 7 for SSI2 slave select
-  GPIO_PORTC_AMSEL_R &= ~0x80; // disable analog of PORTC 7
-  GPIO_PORTC_DATA_R |= 0x80;   // set PORTC 7 idle high
-  GPIO_PORTC_DIR_R |= 0x80;    // set PORTC 7 as output for SS
-  GPIO_PORTC_DEN_R |= 0x80;    // set PORTC 7 as digital pin
-
-  SSI2_CR1_R = 0;      // turn off SSI2 during configuration
-  SSI2_CC_R = 0;       // use system clock
-  SSI2_CPSR_R = 16;    // clock prescaler divide by 16 gets 1 MHz clock
-  SSI2_CR0_R = 0x0007; // clock rate div by 1, phase/polarity 0 0, mode freescale, data size 8
-  SSI2_CR1_R = 2;      // enable SSI2 as master
-}
+// os.c
+// Runs on LM4F120/TM4C123
+// A very simple real time operating system with minimal features.
+// Daniel Valvano
+// January 29, 2015
+
+/* This example accompanies the book
+   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
+   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
+
+   Programs 4.4 through 4.12, section 4.2
+
+ Copyright 2015 by Jonathan W. Valvano, valvano@mail.utexas.edu
+    You may use, edit, run or distribute this file
+    as long as the above copyright notice remains
+ THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
+ OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ For more information about my classes, my research, and my books, see
+ http://users.ece.utexas.edu/~valvano/
+ */
+
+#include <stdint.h>
+#include "os.h"
+#include "BSP.h"
+#include "tm4c123gh6pm.h"
+
+volatile uint32_t Slicecount = 0;
+
+volatile uint32_t TIN = 0;
+
+// function definitions in OSasm.s
+void OS_DisableInterrupts(void); // Disable interrupts
+void OS_EnableInterrupts(void);  // Enable interrupts
+int32_t StartCritical(void);
+void EndCritical(int32_t primask);
+void StartOS(void);
+
+#define NUMTHREADS  6        // maximum number of threads
+#define STACKSIZE   100      // number of 32-bit words in stack
+struct tcb{
+  int32_t *sp;       // pointer to stack (valid for threads not running
+  struct tcb *next;  // linked-list pointer
+  uint32_t TIN;  // thread identification number
+  int32_t *blocked;  // nonzero if blocked on this semaphore
+  uint32_t sleep;    // nonzero if this thread is sleeping (1 ms ticks)
+};
+typedef struct tcb tcbType;
+tcbType tcbs[NUMTHREADS+1]; // the last one is the idle thread, not in the ring
+tcbType *RunPt;
+int32_t Stacks[NUMTHREADS+1][STACKSIZE];
+uint32_t NumThreads = 0;     // threads added so far
+#define IDLE (&tcbs[NUMTHREADS])
+tcbType *LastPt;             // ring thread that ran before the idle thread
+uint32_t IdleCycles;         // bus cycles the idle thread has run, wraps
+uint32_t IdleStart;          // BSP_Cycles when the idle thread started
+uint32_t SleepCycles;        // bus cycles of those asleep, wraps
+uint32_t Sleeps;             // times the idle thread slept
+uint32_t DeepCycles;         // of SleepCycles, those in deep sleep
+uint32_t DeepSleeps;         // of Sleeps, the deep ones
+#define DEEPMIN     2        // ticks to the deadline for a deep sleep
+#define DEEPPAYOFF  4        // ... and times its entry and exit latency
+
+#define NUMPERIODIC 2        // maximum number of periodic event threads
+#define TICKFREQ    1000     // kernel tick in Hz, OS_Sleep resolution
+#define TICKPRI     6        // above SysTick, so a tick can pend a switch
+struct event{
+  void(*task)(void);  // event thread, runs in the kernel tick ISR
+  uint32_t period;    // in ms
+  uint32_t count;     // ms until it runs next
+};
+struct event Events[NUMPERIODIC];
+uint32_t NumEvents = 0;
+uint32_t Running = 0;        // 1 once OS_Launch has started the threads
+
+// 1 if a thread in the ring is ready to run
+static int Ready(void){ uint32_t i;
+  for(i = 0; i < NumThreads; i++){
+    if((tcbs[i].blocked == 0) && (tcbs[i].sleep == 0)){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// kernel ticks until a sleeping thread wakes or an event thread runs,
+// 0xFFFFFFFF if neither will
+static uint32_t Deadline(void){ uint32_t i, next = 0xFFFFFFFF;
+  for(i = 0; i < NumThreads; i++){
+    if(tcbs[i].sleep && (tcbs[i].sleep < next)){
+      next = tcbs[i].sleep;
+    }
+  }
+  for(i = 0; i < NumEvents; i++){
+    if(Events[i].count < next){
+      next = Events[i].count;
+    }
+  }
+  return next;
+}
+
+// ticks skipped in deep sleep, all before the deadline: count them
+// down as RunPeriodicEvents would have, nothing comes due
+static void Skip(uint32_t ticks){ uint32_t i;
+  for(i = 0; i < NumThreads; i++){
+    if(tcbs[i].sleep > ticks){
+      tcbs[i].sleep -= ticks;
+    } else if(tcbs[i].sleep){
+      tcbs[i].sleep = 1;      // the next tick wakes it
+    }
+  }
+  for(i = 0; i < NumEvents; i++){
+    if(Events[i].count > ticks){
+      Events[i].count -= ticks;
+    } else{
+      Events[i].count = 1;
+    }
+  }
+}
+
+// runs when every thread is blocked or sleeping, and sleeps until an
+// interrupt; checked with interrupts disabled, so an interrupt that
+// readies a thread just before the WFI still wakes it at once
+// deep sleep when the next deadline is DEEPPAYOFF times further off
+// than deep sleep takes to enter and leave, plain sleep otherwise
+static void Idle(void){ uint32_t ticks, skipped, slept;
+  for(;;){
+    OS_DisableInterrupts();
+    if(Ready() == 0){
+      ticks = Deadline();
+      slept = 0;
+      if((ticks >= DEEPMIN) && ((uint64_t)ticks*(1000000/TICKFREQ) >=
+                                (uint64_t)DEEPPAYOFF*BSP_DeepLatency())){
+        slept = BSP_DeepSleep(ticks, &skipped);
+      }
+      if(slept){
+        Skip(skipped);
+        DeepCycles += slept;
+        DeepSleeps++;
+      } else{
+        slept = BSP_Sleep();
+      }
+      SleepCycles += slept;
+      Sleeps++;
+    }
+    OS_EnableInterrupts();    // the interrupt that woke it runs here
+    OS_Suspend();
+  }
+}
+
+void SetInitialStack(int i);
+
+// bus clock changed: scale the time slice so it lasts as long as before
+// called with interrupts disabled; the slice in progress ends on the old count
+static void Retime(uint32_t from, uint32_t to){
+  uint64_t slice = ((uint64_t)NVIC_ST_RELOAD_R + 1)*to/from;
+  if(slice > 0x01000000){
+    slice = 0x01000000;         // SysTick reload is 24 bits
+  } else if(slice < 2){
+    slice = 2;
+  }
+  if(Running){                 // not before OS_Launch, which loads it
+    NVIC_ST_RELOAD_R = (uint32_t)slice - 1;
+  }
+}
+
+// ******** OS_Init ************
+// initialize operating system, disable interrupts until OS_Launch
+// initialize OS controlled I/O: systick, board (8 MHz PLL on the LaunchPad)
+// Inputs: none
+// Outputs: none
+void OS_Init(void){
+  OS_DisableInterrupts();
+  BSP_Init();                 // bus clock and board peripherals, see BSP.c
+  BSP_ClockClient(&Retime);   // time slice follows bus clock changes
+  NVIC_ST_CTRL_R = 0;         // disable SysTick during setup
+  NVIC_ST_CURRENT_R = 0;      // any write to current clears it
+  NVIC_SYS_PRI3_R =(NVIC_SYS_PRI3_R&0x00FFFFFF)|0xE0000000; // priority 7
+  NumThreads = 0;
+  NumEvents = 0;
+  SetInitialStack(NUMTHREADS); Stacks[NUMTHREADS][STACKSIZE-2] = (int32_t)(&Idle);
+  IDLE->next = &tcbs[0];      // so OS_Signal can search the ring from it
+  IDLE->TIN = NUMTHREADS;
+  IDLE->blocked = 0;
+  IDLE->sleep = 0;
+  IdleCycles = 0;
+  SleepCycles = 0;
+  Sleeps = 0;
+  DeepCycles = 0;
+  DeepSleeps = 0;
+}
+
+void SetInitialStack(int i){
+  tcbs[i].sp = &Stacks[i][STACKSIZE-16]; // thread stack pointer
+  Stacks[i][STACKSIZE-1] = 0x01000000;   // thumb bit
+  Stacks[i][STACKSIZE-3] = 0x14141414;   // R14
+  Stacks[i][STACKSIZE-4] = 0x12121212;   // R12
+  Stacks[i][STACKSIZE-5] = 0x03030303;   // R3
+  Stacks[i][STACKSIZE-6] = 0x02020202;   // R2
+  Stacks[i][STACKSIZE-7] = 0x01010101;   // R1
+  Stacks[i][STACKSIZE-8] = 0x00000000;   // R0
+  Stacks[i][STACKSIZE-9] = 0x11111111;   // R11
+  Stacks[i][STACKSIZE-10] = 0x10101010;  // R10
+  Stacks[i][STACKSIZE-11] = 0x09090909;  // R9
+  Stacks[i][STACKSIZE-12] = 0x08080808;  // R8
+  Stacks[i][STACKSIZE-13] = 0x07070707;  // R7
+  Stacks[i][STACKSIZE-14] = 0x06060606;  // R6
+  Stacks[i][STACKSIZE-15] = 0x05050505;  // R5
+  Stacks[i][STACKSIZE-16] = 0x04040404;  // R4
+}
+
+// ******** OS_AddThread ***************
+// add one foreground thread to the end of the round-robin ring
+// call before OS_Launch; when every thread is blocked or sleeping the
+// kernel runs its idle thread, which sleeps (WFI) until an interrupt
+// Inputs: pointer to a void/void foreground task
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddThread(void(*task)(void)){ int32_t status; uint32_t i;
+  status = StartCritical();
+  i = NumThreads;
+  if(i >= NUMTHREADS){
+    EndCritical(status);
+    return 0;             // no room
+  }
+  SetInitialStack(i); Stacks[i][STACKSIZE-2] = (int32_t)(task); // PC
+  tcbs[i].next = &tcbs[0]; // last one points back to 0
+  if(i > 0){
+    tcbs[i-1].next = &tcbs[i];
+  }
+  tcbs[i].TIN = i;
+  tcbs[i].blocked = 0;
+  tcbs[i].sleep = 0;
+  RunPt = &tcbs[0];       // thread 0 will run first
+  NumThreads = i+1;
+  EndCritical(status);
+  return 1;               // successful
+}
+
+// ******** OS_AddThreads ***************
+// add three foreground threads to the scheduler
+// Inputs: three pointers to a void/void foreground tasks
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddThreads(void(*task0)(void),
+                 void(*task1)(void),
+                 void(*task2)(void)){
+  NumThreads = 0;         // start a new ring 0 -> 1 -> 2 -> 0
+  return OS_AddThread(task0) && OS_AddThread(task1) && OS_AddThread(task2);
+}
+
+// ******** OS_AddPeriodicEventThread ***************
+// add a background periodic event thread
+// runs in the kernel tick interrupt, so it must not block or sleep
+// Inputs: pointer to a void/void event thread, period in ms
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddPeriodicEventThread(void(*thread)(void), uint32_t period){
+  int32_t status;
+  if(period == 0){
+    return 0;
+  }
+  status = StartCritical();
+  if(NumEvents >= NUMPERIODIC){
+    EndCritical(status);
+    return 0;             // no room
+  }
+  Events[NumEvents].task = thread;
+  Events[NumEvents].period = period;
+  Events[NumEvents].count = period;
+  NumEvents++;
+  EndCritical(status);
+  return 1;
+}
+
+// kernel tick, runs every 1 ms in the BSP periodic interrupt
+// counts down sleeping threads and runs the event threads that are due
+static void RunPeriodicEvents(void){ uint32_t i;
+  for(i = 0; i < NumThreads; i++){
+    if(tcbs[i].sleep){
+      tcbs[i].sleep--;
+    }
+  }
+  for(i = 0; i < NumEvents; i++){
+    Events[i].count--;
+    if(Events[i].count == 0){
+      Events[i].count = Events[i].period;
+      Events[i].task();
+    }
+  }
+}
+
+// ******** Scheduler ***************
+// called from SysTick_Handler with interrupts disabled
+// round robin, skipping threads that are blocked or sleeping; the idle
+// thread runs when none is ready, and the ring picks up after it again
+// from where it left off
+void Scheduler(void){ tcbType *pt; uint32_t i;
+  pt = RunPt;
+  if(RunPt == IDLE){
+    IdleCycles += BSP_Cycles() - IdleStart;
+    pt = LastPt;
+  }
+  for(i = 0; i < NumThreads; i++){
+    pt = pt->next;
+    if((pt->blocked == 0) && (pt->sleep == 0)){
+      RunPt = pt;
+      return;
+    }
+  }
+  LastPt = pt;                // back where it started, nothing ready
+  IdleStart = BSP_Cycles();
+  RunPt = IDLE;
+}
+
+/// ******** OS_Launch ***************
+// start the scheduler and the 1 ms kernel tick, enable interrupts
+// Inputs: number of bus clock cycles for each time slice
+//         (maximum of 24 bits, longer slices are cut to that)
+// Outputs: none (does not return)
+void OS_Launch(uint32_t theTimeSlice){
+  if(theTimeSlice > 0x01000000){
+    theTimeSlice = 0x01000000;  // SysTick reload is 24 bits
+  }
+  BSP_PeriodicTask_Init(&RunPeriodicEvents, TICKFREQ, TICKPRI);
+  NVIC_ST_RELOAD_R = theTimeSlice - 1; // reload value
+  NVIC_ST_CTRL_R = 0x00000007; // enable, core clock and interrupt arm
+  Running = 1;
+  StartOS();                   // start on the first task
+}
+
+// ******** OS_Running ***************
+// drivers block on semaphores only once the scheduler is running
+// Inputs: none
+// Outputs: 1 after OS_Launch, 0 before
+int OS_Running(void){
+  return Running;
+}
+
+// ******** OS_IdleCycles ***************
+// bus cycles spent in the idle thread since OS_Init, for measuring
+// load: 1 - (idle cycles)/(BSP_Cycles elapsed) over a window
+// interrupt handlers that preempt the idle thread count as idle
+// Inputs: none
+// Outputs: 32-bit count, wraps around like BSP_Cycles
+uint32_t OS_IdleCycles(void){ int32_t status; uint32_t idle;
+  status = StartCritical();
+  idle = IdleCycles;
+  if(RunPt == IDLE){
+    idle += BSP_Cycles() - IdleStart;
+  }
+  EndCritical(status);
+  return idle;
+}
+
+// ******** OS_SleepCycles ***************
+// bus cycles the idle thread has spent asleep since OS_Init, part of
+// OS_IdleCycles; the rest is waking up and switching threads
+// Inputs: none
+// Outputs: 32-bit count, wraps around like BSP_Cycles
+uint32_t OS_SleepCycles(void){
+  return SleepCycles;
+}
+
+// ******** OS_Sleeps ***************
+// Inputs: none
+// Outputs: number of times the idle thread has slept since OS_Init
+uint32_t OS_Sleeps(void){
+  return Sleeps;
+}
+
+// ******** OS_DeepSleepCycles ***************
+// of OS_SleepCycles, the bus cycles spent in deep sleep
+// Inputs: none
+// Outputs: 32-bit count, wraps around like BSP_Cycles
+uint32_t OS_DeepSleepCycles(void){
+  return DeepCycles;
+}
+
+// ******** OS_DeepSleeps ***************
+// Inputs: none
+// Outputs: of OS_Sleeps, the number of deep sleeps
+uint32_t OS_DeepSleeps(void){
+  return DeepSleeps;
+}
+
+// ******** OS_Suspend ***************
+// give up the rest of the time slice, the next thread starts a full one
+// Inputs: none
+// Outputs: none
+void OS_Suspend(void){
+  NVIC_ST_CURRENT_R = 0;      // any write to current clears it
+  NVIC_INT_CTRL_R = NVIC_INT_CTRL_PENDSTSET; // trigger SysTick
+}
+
+// ******** OS_Sleep ***************
+// suspend the running thread for at least the given time
+// Inputs: number of 1 ms kernel ticks to sleep
+// Outputs: none
+void OS_Sleep(uint32_t sleepTime){
+  RunPt->sleep = sleepTime;   // the tick counts it down
+  OS_Suspend();
+}
+
+// ******** OS_InitSemaphore ************
+// set the initial value of a semaphore
+// Inputs: pointer to a semaphore, initial value
+// Outputs: none
+void OS_InitSemaphore(int32_t *semaPt, int32_t value){
+  *semaPt = value;
+}
+
+// ******** OS_Wait ************
+// decrement semaphore, block the running thread if it went negative
+// thread only, never call from an interrupt handler
+// Inputs: pointer to a counting semaphore
+// Outputs: none
+void OS_Wait(int32_t *semaPt){
+  OS_DisableInterrupts();
+  (*semaPt) = (*semaPt) - 1;
+  if((*semaPt) < 0){
+    RunPt->blocked = semaPt;  // reason it is blocked
+    OS_EnableInterrupts();
+    OS_Suspend();             // run thread switcher
+  }
+  OS_EnableInterrupts();
+}
+
+// ******** OS_Signal ************
+// increment semaphore, wake up one thread blocked on it
+// the woken thread runs when the scheduler gets to it
+// may be called from a thread or an interrupt handler
+// Inputs: pointer to a counting semaphore
+// Outputs: none
+void OS_Signal(int32_t *semaPt){ int32_t status; tcbType *pt;
+  status = StartCritical();
+  (*semaPt) = (*semaPt) + 1;
+  if((*semaPt) <= 0){
+    pt = RunPt->next;         // search for a thread blocked on this semaphore
+    while(pt->blocked != semaPt){
+      pt = pt->next;
+    }
+    pt->blocked = 0;          // wakeup this one
+  }
+  EndCritical(status);
+}
+
+#define FSIZE 10             // can be any size
+uint32_t PutI;               // index of where to put next
+uint32_t GetI;               // index of where to get next
+uint32_t Fifo[FSIZE];
+int32_t CurrentSize;         // 0 means FIFO empty, FSIZE means full
+uint32_t LostData;           // number of OS_FIFO_Put failures
+
+// ******** OS_FIFO_Init ************
+// initialize the kernel FIFO
+// Inputs: none
+// Outputs: none
+void OS_FIFO_Init(void){
+  PutI = GetI = 0;
+  OS_InitSemaphore(&CurrentSize, 0);
+  LostData = 0;
+}
+
+// ******** OS_FIFO_Put ************
+// enter one item into the FIFO, wake up a thread waiting in OS_FIFO_Get
+// may be called from a thread or an interrupt handler (single producer)
+// Inputs: data to be stored
+// Outputs: 0 if successful, -1 if the FIFO is full and the data is lost
+int OS_FIFO_Put(uint32_t data){
+  if(CurrentSize == FSIZE){
+    LostData++;
+    return -1;                // full
+  }
+  Fifo[PutI] = data;
+  PutI = (PutI+1)%FSIZE;
+  OS_Signal(&CurrentSize);
+  return 0;
+}
+
+// ******** OS_FIFO_Get ************
+// remove one item from the FIFO, block while it is empty
+// thread only, single consumer
+// Inputs: none
+// Outputs: data retrieved
+uint32_t OS_FIFO_Get(void){ uint32_t data;
+  OS_Wait(&CurrentSize);      // block if empty
+  data = Fifo[GetI];
+  GetI = (GetI+1)%FSIZE;
+  return data;
+}
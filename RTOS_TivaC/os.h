@@ -1,54 +1,160 @@
-// os.h
-// Runs on LM4F120/TM4C123
-// A very simple real time operating system with minimal features.
-// Daniel Valvano
-// January 29, 2015
-
-/* This example accompanies the book
-   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
-   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
-
-   Programs 4.4 through 4.12, section 4.2
-
- Copyright 2015 by Jonathan W. Valvano, valvano@mail.utexas.edu
-    You may use, edit, run or distribute this file
-    as long as the above copyright notice remains
- THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
- OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- For more information about my classes, my research, and my books, see
- http://users.ece.utexas.edu/~valvano/
- */
-
-
-#ifndef __OS_H__
-#define __OS_H__
-
-// ******** OS_Init ************
-// initialize operating system, disable interrupts until OS_Launch
-// initialize OS controlled I/O: SysTick, 16 MHz PLL
-// Inputs: none
-// Outputs: none
-void OS_Init(void);
-
-// ******** OS_AddThread ***************
-// add three foreground threads to the scheduler
-// Inputs: three pointers to a void/void foreground tasks
-// Outputs: 1 if successful, 0 if this thread can not be added
-int OS_AddThreads(void(*task0)(void),
-                 void(*task1)(void),
-                 void(*task2)(void));
-
-// ******** OS_Launch ***************
-// start the scheduler, enable interrupts
-// Inputs: number of bus clock cycles for each time slice
-//         (maximum of 24 bits)
-// Outputs: none (does not return)
-void OS_Launch(uint32_t theTimeSlice);
-
-// enable SSI2 and associated GPIO pins
-void sevenseg_init(void);
-
-#endif
+// os.h
+// Runs on LM4F120/TM4C123
+// A very simple real time operating system with minimal features.
+// Daniel Valvano
+// January 29, 2015
+
+/* This example accompanies the book
+   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
+   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
+
+   Programs 4.4 through 4.12, section 4.2
+
+ Copyright 2015 by Jonathan W. Valvano, valvano@mail.utexas.edu
+    You may use, edit, run or distribute this file
+    as long as the above copyright notice remains
+ THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
+ OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ For more information about my classes, my research, and my books, see
+ http://users.ece.utexas.edu/~valvano/
+ */
+
+
+#ifndef __OS_H__
+#define __OS_H__
+
+// ******** OS_Init ************
+// initialize operating system, disable interrupts until OS_Launch
+// initialize OS controlled I/O: SysTick, 16 MHz PLL
+// Inputs: none
+// Outputs: none
+void OS_Init(void);
+
+// ******** OS_AddThread ***************
+// add one foreground thread to the end of the round-robin ring
+// call before OS_Launch; when every thread is blocked or sleeping the
+// kernel runs its idle thread, which sleeps (WFI) until an interrupt
+// Inputs: pointer to a void/void foreground task
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddThread(void(*task)(void));
+
+// ******** OS_AddThreads ***************
+// add three foreground threads to the scheduler
+// Inputs: three pointers to a void/void foreground tasks
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddThreads(void(*task0)(void),
+                 void(*task1)(void),
+                 void(*task2)(void));
+
+// ******** OS_AddPeriodicEventThread ***************
+// add a background periodic event thread
+// runs in the kernel tick interrupt, so it must not block or sleep
+// Inputs: pointer to a void/void event thread, period in ms
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddPeriodicEventThread(void(*thread)(void), uint32_t period);
+
+// ******** OS_Launch ***************
+// start the scheduler and the 1 ms kernel tick, enable interrupts
+// Inputs: number of bus clock cycles for each time slice
+//         (maximum of 24 bits, longer slices are cut to that)
+// Outputs: none (does not return)
+void OS_Launch(uint32_t theTimeSlice);
+
+// ******** OS_Running ***************
+// drivers block on semaphores only once the scheduler is running
+// Inputs: none
+// Outputs: 1 after OS_Launch, 0 before
+int OS_Running(void);
+
+// ******** OS_IdleCycles ***************
+// bus cycles spent in the idle thread since OS_Init, for measuring
+// load: 1 - (idle cycles)/(BSP_Cycles elapsed) over a window
+// interrupt handlers that preempt the idle thread count as idle
+// Inputs: none
+// Outputs: 32-bit count, wraps around like BSP_Cycles
+uint32_t OS_IdleCycles(void);
+
+// ******** OS_SleepCycles ***************
+// bus cycles the idle thread has spent asleep since OS_Init, part of
+// OS_IdleCycles; the rest is waking up and switching threads
+// Inputs: none
+// Outputs: 32-bit count, wraps around like BSP_Cycles
+uint32_t OS_SleepCycles(void);
+
+// ******** OS_Sleeps ***************
+// Inputs: none
+// Outputs: number of times the idle thread has slept since OS_Init
+uint32_t OS_Sleeps(void);
+
+// ******** OS_DeepSleepCycles ***************
+// of OS_SleepCycles, the bus cycles spent in deep sleep; the idle
+// thread sleeps deep while nothing but the kernel tick is timing
+// anything (drivers stop what is idle, BSP_DeepClient) and the next
+// sleeping thread or event thread is due far enough off to pay for the
+// time deep sleep takes to enter and leave
+// Inputs: none
+// Outputs: 32-bit count, wraps around like BSP_Cycles
+uint32_t OS_DeepSleepCycles(void);
+
+// ******** OS_DeepSleeps ***************
+// Inputs: none
+// Outputs: of OS_Sleeps, the number of deep sleeps
+uint32_t OS_DeepSleeps(void);
+
+// ******** OS_Suspend ***************
+// give up the rest of the time slice, the next thread starts a full one
+// Inputs: none
+// Outputs: none
+void OS_Suspend(void);
+
+// ******** OS_Sleep ***************
+// suspend the running thread for at least the given time
+// Inputs: number of 1 ms kernel ticks to sleep
+// Outputs: none
+void OS_Sleep(uint32_t sleepTime);
+
+// ******** OS_InitSemaphore ************
+// set the initial value of a semaphore
+// Inputs: pointer to a semaphore, initial value
+// Outputs: none
+void OS_InitSemaphore(int32_t *semaPt, int32_t value);
+
+// ******** OS_Wait ************
+// decrement semaphore, block the running thread if it went negative
+// thread only, never call from an interrupt handler
+// Inputs: pointer to a counting semaphore
+// Outputs: none
+void OS_Wait(int32_t *semaPt);
+
+// ******** OS_Signal ************
+// increment semaphore, wake up one thread blocked on it
+// the woken thread runs when the scheduler gets to it
+// may be called from a thread or an interrupt handler
+// Inputs: pointer to a counting semaphore
+// Outputs: none
+void OS_Signal(int32_t *semaPt);
+
+// ******** OS_FIFO_Init ************
+// initialize the kernel FIFO
+// Inputs: none
+// Outputs: none
+void OS_FIFO_Init(void);
+
+// ******** OS_FIFO_Put ************
+// enter one item into the FIFO, wake up a thread waiting in OS_FIFO_Get
+// may be called from a thread or an interrupt handler (single producer)
+// Inputs: data to be stored
+// Outputs: 0 if successful, -1 if the FIFO is full and the data is lost
+int OS_FIFO_Put(uint32_t data);
+
+// ******** OS_FIFO_Get ************
+// remove one item from the FIFO, block while it is empty
+// thread only, single consumer
+// Inputs: none
+// Outputs: data retrieved
+uint32_t OS_FIFO_Get(void);
+
+#endif
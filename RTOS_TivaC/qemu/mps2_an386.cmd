@@ -0,0 +1,37 @@
+/******************************************************************************
+ *
+ * Linker command file for the QEMU mps2-an386 machine (Cortex-M4)
+ *
+ * Same section layout as tm4c123gh6pm.cmd so the startup file and the
+ * kernel link unchanged.  QEMU loads the image into ZBT SSRAM1 at 0 and
+ * boots from the vector table there.
+ *
+ *****************************************************************************/
+
+--retain=g_pfnVectors
+
+MEMORY
+{
+    FLASH (RX) : origin = 0x00000000, length = 0x00400000
+    SRAM (RWX) : origin = 0x20000000, length = 0x00010000
+}
+
+/* Section allocation in memory */
+
+SECTIONS
+{
+    .intvecs:   > 0x00000000
+    .text   :   > FLASH
+    .const  :   > FLASH
+    .cinit  :   > FLASH
+    .pinit  :   > FLASH
+    .init_array : > FLASH
+
+    .vtable :   > 0x20000000
+    .data   :   > SRAM
+    .bss    :   > SRAM
+    .sysmem :   > SRAM
+    .stack  :   > SRAM
+}
+
+__STACK_TOP = __stack + 512;
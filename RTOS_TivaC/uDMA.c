@@ -0,0 +1,333 @@
+// uDMA.c
+// Runs on TM4C123
+// Micro-DMA controller driver, see uDMA.h.
+// The control table holds 32 primary then 32 alternate structures and
+// must be 1024-byte aligned.  A channel's completion interrupt goes to
+// its peripheral's vector (the handler calls uDMA_Complete), except the
+// software channel, which interrupts through uDMA_Handler.
+
+// Adapted from the uDMA examples in the book:
+/* "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
+   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
+   Section 6.5
+*/
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "uDMA.h"
+#include "Clock.h"
+
+uint32_t StartCritical (void);   // previous I bit, disable interrupts
+void EndCritical( uint32_t sr ); // restore I bit to previous value
+
+// control word fields
+#define CTL_DSTINC_SHIFT  30
+#define CTL_DSTSIZE_SHIFT 28
+#define CTL_SRCINC_SHIFT  26
+#define CTL_SRCSIZE_SHIFT 24
+#define CTL_ARBSIZE_SHIFT 14
+#define CTL_XFERSIZE_SHIFT 4
+#define CTL_INC_NONE      3
+#define CTL_MODE_M        0x00000007
+#define MODE_STOP         0
+#define MODE_BASIC        1
+#define MODE_AUTO         2
+#define MODE_PINGPONG     3
+#define MODE_MEM_SG       4
+#define MODE_MEM_SGA      5
+#define MODE_PER_SG       6
+#define MODE_PER_SGA      7
+
+#define ALT               32    // alternate structures follow the primaries
+#define UDMA_PRI          2     // software channel and error interrupts
+
+uDMA_Task ControlTable[64] __attribute__((aligned(1024)));
+
+static uDMA_Callback Callback[32];
+static uint32_t Reload[32];     // ping-pong control words, re-armed on completion
+static uint32_t PingPong;       // channels running ping-pong
+static uint32_t Armed;          // channels with a transfer to report
+volatile uint32_t uDMA_Errors;
+
+// ******** uDMA_Init ************
+// activate the uDMA controller and its control table; every driver
+// using the uDMA calls it, only the first sets it up
+// Inputs: none
+// Outputs: none
+void uDMA_Init(void){
+  if(Clock_Acquire(CLOCK_DMA, 0) == 0){
+    return;                               // another driver set it up already
+  }
+  UDMA_CFG_R = 0x01;                      // MASTEN, enable the controller
+  UDMA_CTLBASE_R = (uint32_t)ControlTable;
+  UDMA_ENACLR_R = 0xFFFFFFFF;             // all channels off
+  UDMA_CHIS_R = 0xFFFFFFFF;               // clear completion flags
+  UDMA_ERRCLR_R = 1;
+  PingPong = 0;
+  Armed = 0;
+  uDMA_Errors = 0;
+  uDMA_Assign(UDMA_SW, 0);
+  NVIC_PRI11_R = (NVIC_PRI11_R&0x1F1FFFFF)|(UDMA_PRI<<21)|(UDMA_PRI<<29); // IRQ 46, 47
+  NVIC_EN1_R = (1<<(46-32))|(1<<(47-32)); // software and error interrupts
+}
+
+// ******** uDMA_Assign ************
+// connect a channel to a peripheral request and reset its attributes
+// Inputs: channel 0 to 31, encoding from the channel assignment table
+//         (datasheet table 9-1)
+// Outputs: none
+void uDMA_Assign(uint32_t channel, uint32_t encoding){
+  volatile uint32_t *map = &UDMA_CHMAP0_R + channel/8;
+  uint32_t shift = (channel%8)*4;
+  uint32_t bit = 1u<<channel;
+  UDMA_ENACLR_R = bit;
+  *map = (*map&~(0x0Fu<<shift))|((encoding&0x0F)<<shift);
+  UDMA_ALTCLR_R = bit;                    // start with the primary structure
+  UDMA_USEBURSTCLR_R = bit;
+  UDMA_REQMASKCLR_R = bit;                // let the peripheral request
+  UDMA_PRIOCLR_R = bit;
+}
+
+// control word for count items of the size in flags
+static uint32_t Control(uint32_t flags, uint32_t count, uint32_t mode){
+  uint32_t size = flags&0x03;
+  uint32_t srcinc = (flags&UDMA_SRC_FIXED) ? CTL_INC_NONE : size;
+  uint32_t dstinc = (flags&UDMA_DST_FIXED) ? CTL_INC_NONE : size;
+  return (dstinc<<CTL_DSTINC_SHIFT)|(size<<CTL_DSTSIZE_SHIFT)|
+         (srcinc<<CTL_SRCINC_SHIFT)|(size<<CTL_SRCSIZE_SHIFT)|
+         (((flags>>4)&0x0F)<<CTL_ARBSIZE_SHIFT)|
+         ((count-1)<<CTL_XFERSIZE_SHIFT)|mode;
+}
+
+// the controller wants the address of the last item, not the first
+static volatile void *End(const volatile void *pt, uint32_t count, uint32_t flags, uint32_t fixed){
+  if(flags&fixed){
+    return (volatile void *)pt;
+  }
+  return (volatile uint8_t *)pt + ((count-1)<<(flags&0x03));
+}
+
+static void Fill(uDMA_Task *t, const volatile void *src, volatile void *dst,
+                 uint32_t count, uint32_t flags, uint32_t mode){
+  t->srcEnd = End(src, count, flags, UDMA_SRC_FIXED);
+  t->dstEnd = End(dst, count, flags, UDMA_DST_FIXED);
+  t->control = Control(flags, count, mode);
+}
+
+// channel attributes from the flags, then go
+static void Launch(uint32_t channel, uint32_t flags, uDMA_Callback done){
+  uint32_t bit = 1u<<channel;
+  uint32_t sr;
+  if(flags&UDMA_BURST){
+    UDMA_USEBURSTSET_R = bit;
+  } else{
+    UDMA_USEBURSTCLR_R = bit;
+  }
+  if(flags&UDMA_HIGHPRI){
+    UDMA_PRIOSET_R = bit;
+  } else{
+    UDMA_PRIOCLR_R = bit;
+  }
+  sr = StartCritical();
+  Callback[channel] = done;
+  Armed |= bit;
+  UDMA_CHIS_R = bit;                      // forget an old completion
+  EndCritical(sr);
+  UDMA_ENASET_R = bit;
+}
+
+// ******** uDMA_Basic ************
+// one block from src to dst, one request per arbitration size
+// Inputs: channel, source, destination, number of items (1 to 1024),
+//         flags, completion callback (may be 0)
+// Outputs: none
+void uDMA_Basic(uint32_t channel, const volatile void *src, volatile void *dst,
+                uint32_t count, uint32_t flags, uDMA_Callback done){
+  PingPong &= ~(1u<<channel);
+  UDMA_ALTCLR_R = 1u<<channel;
+  Fill(&ControlTable[channel], src, dst, count, flags, MODE_BASIC);
+  Launch(channel, flags, done);
+}
+
+// ******** uDMA_PingPong ************
+// alternate between two buffers until uDMA_Stop; each buffer is
+// re-armed as soon as it completes, then done(channel, alt) is called
+// so the software can empty or refill it while the other one runs
+// Inputs: channel, source/destination of the primary (alt = 0) and
+//         alternate (alt = 1) buffers, items per buffer, flags, callback
+// Outputs: none
+void uDMA_PingPong(uint32_t channel,
+                   const volatile void *srcA, volatile void *dstA,
+                   const volatile void *srcB, volatile void *dstB,
+                   uint32_t count, uint32_t flags, uDMA_Callback done){
+  UDMA_ALTCLR_R = 1u<<channel;
+  Fill(&ControlTable[channel], srcA, dstA, count, flags, MODE_PINGPONG);
+  Fill(&ControlTable[channel+ALT], srcB, dstB, count, flags, MODE_PINGPONG);
+  Reload[channel] = ControlTable[channel].control;
+  PingPong |= 1u<<channel;
+  Launch(channel, flags, done);
+}
+
+// ******** uDMA_MakeTask ************
+// fill in one scatter-gather task
+// Inputs: task, source, destination, number of items, flags,
+//         1 for peripheral scatter-gather (one request per arbitration),
+//         1 if this is the last task of the list
+// Outputs: none
+void uDMA_MakeTask(uDMA_Task *task, const volatile void *src, volatile void *dst,
+                   uint32_t count, uint32_t flags, int periph, int last){
+  uint32_t mode;
+  if(last){
+    mode = periph ? MODE_BASIC : MODE_AUTO;
+  } else{
+    mode = periph ? MODE_PER_SGA : MODE_MEM_SGA; // back to the primary after
+  }
+  Fill(task, src, dst, count, flags, mode);
+  task->spare = 0;
+}
+
+// primary control structure that walks a task list, 4 words per task
+static void ListControl(uDMA_Task *t, uint32_t channel, const uDMA_Task *tasks,
+                        uint32_t n, int periph){
+  t->srcEnd = (volatile void *)&tasks[n-1].spare;
+  t->dstEnd = &ControlTable[channel+ALT].spare;
+  t->control = Control(UDMA_32BIT|UDMA_ARB(2), 4*n,
+                       periph ? MODE_PER_SG : MODE_MEM_SG);
+  t->spare = 0;
+}
+
+// ******** uDMA_LoopTask ************
+// make the last task of a list restart the list, so a peripheral
+// scatter-gather runs forever with no CPU involvement; the task copies
+// the initial primary control structure, kept in *saved, back into the
+// control table (4 words in one arbitration)
+// Inputs: task (the last one of the list), storage for the saved copy,
+//         channel, task list, number of tasks including this one,
+//         1 for peripheral scatter-gather
+// Outputs: none
+void uDMA_LoopTask(uDMA_Task *task, uDMA_Task *saved, uint32_t channel,
+                   const uDMA_Task *tasks, uint32_t n, int periph){
+  ListControl(saved, channel, tasks, n, periph);
+  uDMA_MakeTask(task, saved, &ControlTable[channel], 4, UDMA_32BIT|UDMA_ARB(2),
+                periph, 0);
+}
+
+// ******** uDMA_ScatterGather ************
+// run a list of tasks built with uDMA_MakeTask (and uDMA_LoopTask)
+// Inputs: channel, task list, number of tasks (1 to 256), 1 for
+//         peripheral scatter-gather, callback after the last task
+// Outputs: none
+void uDMA_ScatterGather(uint32_t channel, const uDMA_Task *tasks, uint32_t n,
+                        int periph, uDMA_Callback done){
+  PingPong &= ~(1u<<channel);
+  UDMA_ALTCLR_R = 1u<<channel;
+  ListControl(&ControlTable[channel], channel, tasks, n, periph);
+  Launch(channel, 0, done);
+}
+
+// ******** uDMA_Copy ************
+// memory to memory on the software channel, done runs in uDMA_Handler
+// Inputs: destination, source, number of items (1 to 1024), flags
+//         (size only), callback (may be 0)
+// Outputs: 1 if started, 0 if the software channel is busy
+int uDMA_Copy(void *dst, const void *src, uint32_t count, uint32_t flags,
+              uDMA_Callback done){
+  if(uDMA_Busy(UDMA_SW)){
+    return 0;
+  }
+  flags = (flags&0x03)|UDMA_ARB(3);       // 8 items per arbitration
+  UDMA_ALTCLR_R = 1u<<UDMA_SW;
+  Fill(&ControlTable[UDMA_SW], src, dst, count, flags, MODE_AUTO);
+  Launch(UDMA_SW, flags, done);
+  UDMA_SWREQ_R = 1u<<UDMA_SW;             // auto mode runs to the end
+  return 1;
+}
+
+// ******** uDMA_Stop ************
+// disable a channel; a transfer in progress is abandoned
+// Inputs: channel
+// Outputs: none
+void uDMA_Stop(uint32_t channel){
+  uint32_t sr;
+  UDMA_ENACLR_R = 1u<<channel;
+  sr = StartCritical();
+  PingPong &= ~(1u<<channel);
+  Armed &= ~(1u<<channel);
+  EndCritical(sr);
+}
+
+// ******** uDMA_Busy ************
+// Inputs: channel
+// Outputs: 1 while the channel is enabled (transfer not complete)
+int uDMA_Busy(uint32_t channel){
+  return (UDMA_ENASET_R>>channel)&1;
+}
+
+// ******** uDMA_Mask ************
+// hold off or let through a channel's peripheral requests; a masked
+// channel keeps its place and carries on where it stopped
+// Inputs: channel, 1 to mask, 0 to unmask
+// Outputs: none
+void uDMA_Mask(uint32_t channel, int masked){
+  if(masked){
+    UDMA_REQMASKSET_R = 1u<<channel;
+  } else{
+    UDMA_REQMASKCLR_R = 1u<<channel;
+  }
+}
+
+// ******** uDMA_Remaining ************
+// items the primary structure still has to move; for a scatter-gather
+// list that is 4 per task not yet started
+// Inputs: channel
+// Outputs: 0 when the primary structure has stopped
+uint32_t uDMA_Remaining(uint32_t channel){
+  uint32_t control = ControlTable[channel].control;
+  if((control&CTL_MODE_M) == MODE_STOP){
+    return 0;
+  }
+  return ((control>>CTL_XFERSIZE_SHIFT)&0x3FF)+1;
+}
+
+// ******** uDMA_Complete ************
+// handle the completion interrupt of peripheral channels; call it from
+// the peripheral's handler, where the uDMA signals completion
+// Inputs: mask of the channels this handler serves
+// Outputs: mask of the channels that completed
+uint32_t uDMA_Complete(uint32_t mask){
+  uint32_t status, channel, bit;
+  status = UDMA_CHIS_R&mask&Armed;
+  UDMA_CHIS_R = status;                   // acknowledge
+  for(channel = 0; channel < 32; channel++){
+    bit = 1u<<channel;
+    if((status&bit) == 0){
+      continue;
+    }
+    if(PingPong&bit){                     // re-arm whichever half stopped
+      if((ControlTable[channel].control&CTL_MODE_M) == MODE_STOP){
+        ControlTable[channel].control = Reload[channel];
+        if(Callback[channel]) Callback[channel](channel, 0);
+      }
+      if((ControlTable[channel+ALT].control&CTL_MODE_M) == MODE_STOP){
+        ControlTable[channel+ALT].control = Reload[channel];
+        if(Callback[channel]) Callback[channel](channel, 1);
+      }
+      UDMA_ENASET_R = bit;                // in case both halves ran out
+    } else{
+      Armed &= ~bit;
+      if(Callback[channel]) Callback[channel](channel, 0);
+    }
+  }
+  return status;
+}
+
+// software channel completion
+void uDMA_Handler(void){
+  uDMA_Complete(1u<<UDMA_SW);
+}
+
+// bus error on any channel; the channel that failed is disabled
+void uDMA_Error(void){
+  UDMA_ERRCLR_R = 1;
+  uDMA_Errors++;
+}
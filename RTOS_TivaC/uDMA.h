@@ -0,0 +1,163 @@
+// uDMA.h
+// Runs on TM4C123
+// Micro-DMA controller driver: channel control table, channel
+// assignment, basic, ping-pong and scatter-gather transfers with
+// completion callbacks, and memory-to-memory copies.
+
+// Adapted from the uDMA examples in the book:
+/* "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
+   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
+   Section 6.5
+*/
+
+#ifndef __UDMA_H__
+#define __UDMA_H__
+
+#include <stdint.h>
+
+// channel assignments used on this board (channel, encoding)
+#define UDMA_SW           30   // dedicated software channel, any encoding
+#define UDMA_SSI2RX       12   // encoding 2
+#define UDMA_SSI2TX       13   // encoding 2
+#define UDMA_ADC0SS0      14   // encoding 0
+#define UDMA_ADC0SS3      17   // encoding 0
+#define UDMA_TIMER0A      18   // encoding 0
+#define UDMA_TIMER1A      20   // encoding 0
+#define UDMA_SSI2_ENC     2
+#define UDMA_ADC0_ENC     0
+#define UDMA_TIMER_ENC    0
+
+// transfer flags, one item size plus any of the others
+#define UDMA_8BIT         0x00000000  // items are bytes
+#define UDMA_16BIT        0x00000001  // items are halfwords
+#define UDMA_32BIT        0x00000002  // items are words
+#define UDMA_SRC_FIXED    0x00000004  // source does not increment (data register)
+#define UDMA_DST_FIXED    0x00000008  // destination does not increment
+#define UDMA_ARB(n)       (((n)&0x0F)<<4) // re-arbitrate every 2^n items, n = 0 to 10
+#define UDMA_BURST        0x00000100  // respond to burst requests only
+#define UDMA_HIGHPRI      0x00000200  // high priority channel
+
+#define UDMA_MAXITEMS     1024        // per transfer, per buffer or per task
+
+// called in interrupt context when a transfer completes
+// channel: 0 to 31; alt: 0 if the primary buffer (or the only one) is
+// done, 1 if the alternate buffer of a ping-pong transfer is done
+typedef void (*uDMA_Callback)(uint32_t channel, uint32_t alt);
+
+// one entry of the channel control table, also the format of a
+// scatter-gather task
+struct uDMA_Control{
+  volatile void *srcEnd;      // address of the last source item
+  volatile void *dstEnd;      // address of the last destination item
+  volatile uint32_t control;  // sizes, increments, count and mode
+  uint32_t spare;
+};
+typedef struct uDMA_Control uDMA_Task;
+
+// ******** uDMA_Init ************
+// activate the uDMA controller and its control table; every driver
+// using the uDMA calls it, only the first sets it up
+// Inputs: none
+// Outputs: none
+void uDMA_Init(void);
+
+// ******** uDMA_Assign ************
+// connect a channel to a peripheral request and reset its attributes
+// Inputs: channel 0 to 31, encoding from the channel assignment table
+//         (datasheet table 9-1)
+// Outputs: none
+void uDMA_Assign(uint32_t channel, uint32_t encoding);
+
+// ******** uDMA_Basic ************
+// one block from src to dst, one request per arbitration size
+// Inputs: channel, source, destination, number of items (1 to 1024),
+//         flags, completion callback (may be 0)
+// Outputs: none
+void uDMA_Basic(uint32_t channel, const volatile void *src, volatile void *dst,
+                uint32_t count, uint32_t flags, uDMA_Callback done);
+
+// ******** uDMA_PingPong ************
+// alternate between two buffers until uDMA_Stop; each buffer is
+// re-armed as soon as it completes, then done(channel, alt) is called
+// so the software can empty or refill it while the other one runs
+// Inputs: channel, source/destination of the primary (alt = 0) and
+//         alternate (alt = 1) buffers, items per buffer, flags, callback
+// Outputs: none
+void uDMA_PingPong(uint32_t channel,
+                   const volatile void *srcA, volatile void *dstA,
+                   const volatile void *srcB, volatile void *dstB,
+                   uint32_t count, uint32_t flags, uDMA_Callback done);
+
+// ******** uDMA_MakeTask ************
+// fill in one scatter-gather task
+// Inputs: task, source, destination, number of items, flags,
+//         1 for peripheral scatter-gather (one request per arbitration),
+//         1 if this is the last task of the list
+// Outputs: none
+void uDMA_MakeTask(uDMA_Task *task, const volatile void *src, volatile void *dst,
+                   uint32_t count, uint32_t flags, int periph, int last);
+
+// ******** uDMA_LoopTask ************
+// make the last task of a list restart the list, so a peripheral
+// scatter-gather runs forever with no CPU involvement; the task copies
+// the initial primary control structure, kept in *saved, back into the
+// control table (4 words in one arbitration)
+// Inputs: task (the last one of the list), storage for the saved copy,
+//         channel, task list, number of tasks including this one,
+//         1 for peripheral scatter-gather
+// Outputs: none
+void uDMA_LoopTask(uDMA_Task *task, uDMA_Task *saved, uint32_t channel,
+                   const uDMA_Task *tasks, uint32_t n, int periph);
+
+// ******** uDMA_ScatterGather ************
+// run a list of tasks built with uDMA_MakeTask (and uDMA_LoopTask)
+// Inputs: channel, task list, number of tasks (1 to 256), 1 for
+//         peripheral scatter-gather, callback after the last task
+// Outputs: none
+void uDMA_ScatterGather(uint32_t channel, const uDMA_Task *tasks, uint32_t n,
+                        int periph, uDMA_Callback done);
+
+// ******** uDMA_Copy ************
+// memory to memory on the software channel, done runs in uDMA_Handler
+// Inputs: destination, source, number of items (1 to 1024), flags
+//         (size only), callback (may be 0)
+// Outputs: 1 if started, 0 if the software channel is busy
+int uDMA_Copy(void *dst, const void *src, uint32_t count, uint32_t flags,
+              uDMA_Callback done);
+
+// ******** uDMA_Stop ************
+// disable a channel; a transfer in progress is abandoned
+// Inputs: channel
+// Outputs: none
+void uDMA_Stop(uint32_t channel);
+
+// ******** uDMA_Busy ************
+// Inputs: channel
+// Outputs: 1 while the channel is enabled (transfer not complete)
+int uDMA_Busy(uint32_t channel);
+
+// ******** uDMA_Mask ************
+// hold off or let through a channel's peripheral requests; a masked
+// channel keeps its place and carries on where it stopped
+// Inputs: channel, 1 to mask, 0 to unmask
+// Outputs: none
+void uDMA_Mask(uint32_t channel, int masked);
+
+// ******** uDMA_Remaining ************
+// items the primary structure still has to move; for a scatter-gather
+// list that is 4 per task not yet started
+// Inputs: channel
+// Outputs: 0 when the primary structure has stopped
+uint32_t uDMA_Remaining(uint32_t channel);
+
+// ******** uDMA_Complete ************
+// handle the completion interrupt of peripheral channels; call it from
+// the peripheral's handler, where the uDMA signals completion
+// Inputs: mask of the channels this handler serves
+// Outputs: mask of the channels that completed
+uint32_t uDMA_Complete(uint32_t mask);
+
+// number of bus errors reported by the controller
+extern volatile uint32_t uDMA_Errors;
+
+#endif
@@ -1,84 +1,135 @@
-// Modified from textbook to operate using 16 MHz bus clock, changed user tasks, and using RGB LED at Port F
-// TODO: Modify TIMESLICE value
-
-//*****************************************************************************
-// user.c
-// Runs on LM4F120/TM4C123
-// An example user program that initializes the simple operating system
-//   Schedule three independent threads using preemptive round robin  
-//   Each thread rapidly toggles a pin on Port D and increments its counter 
-//   TIMESLICE is how long each thread runs
-
-// Daniel Valvano
-// January 29, 2015
-
-/* This example accompanies the book
-   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
-   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
-
-   Programs 4.4 through 4.12, section 4.2
-
- Copyright 2015 by Jonathan W. Valvano, valvano@mail.utexas.edu
-    You may use, edit, run or distribute this file
-    as long as the above copyright notice remains
- THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
- OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- For more information about my classes, my research, and my books, see
- http://users.ece.utexas.edu/~valvano/
- */
-
-#include <stdint.h>
-#include "os.h"
-#include "LCD.h"
-#include "timer0A.h"
-#include "Timer3A.h"
-#include "tm4c123gh6pm.h"
-
-#define TIMESLICE  8000000   // TODO: define the thread switch time in number of SysTick counts (bus clock cycles at 8 MHz)
-
-uint32_t Count1;   // number of times thread1 loops
-uint32_t Count2;   // number of times thread2 loops
-uint32_t Count3;   // number of times thread3 loops
-
-void Task1(void)
-{
-  Count1 = 0;
-  for (;;)
-  {
-    Count1++;
-    GPIO_PORTF_DATA_R = (GPIO_PORTF_DATA_R & ~0x0E) | (0x04 << 1); // Show green
-  }
-}
-
-void Task2(void){
-  Count2 = 0;
-  for(;;){
-    Count2++;
-    GPIO_PORTF_DATA_R = (GPIO_PORTF_DATA_R & ~0x0E) | (0x02<<1);  // Show blue
-  }
-}
-
-void Task3(void){
-  Count3 = 0;
-  for(;;){
-    Count3++;
-    GPIO_PORTF_DATA_R = (GPIO_PORTF_DATA_R & ~0x0E) | (0x03<<1);  // Show red + blue = purple/magenta
-  }
-}
-
-int main(void){
-  OS_Init();           // initialize, disable interrupts, set PLL to 16 MHz
-  SYSCTL_RCGCGPIO_R |= 0x20;            // activate clock for Port F
-  while((SYSCTL_PRGPIO_R&0x20) == 0){}; // allow time for clock to stabilize
-  GPIO_PORTF_DIR_R |= 0x0E;             // make PF3-1 out
-  GPIO_PORTF_AFSEL_R &= ~0x0E;          // disable alt funct on PF3-1
-  GPIO_PORTF_DEN_R |= 0x0E;             // enable digital I/O on PF3-1
-  GPIO_PORTF_PCTL_R &= ~0x0000FFF0;     // configure PF3-1 as GPIO
-  GPIO_PORTF_AMSEL_R &= ~0x0E;          // disable analog functionality on PF3-1
-  OS_AddThreads(&Task1, &Task2, &Task3);
-  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
-  return 0;             // this never executes
-}
+// Modified from textbook to operate using 16 MHz bus clock, changed user tasks, and using RGB LED at Port F
+
+//*****************************************************************************
+// user.c
+// Runs on LM4F120/TM4C123
+// An example user program that initializes the simple operating system
+//   Schedule three independent threads using preemptive round robin
+//   Each thread does a fixed amount of work every TASK_MS, shows its
+//   color on the LED and sleeps the rest; thread 3 alternates heavy
+//   and light phases, so the governor has a load to follow and the
+//   idle thread gets to sleep
+//   TIMESLICE_MS is how long each thread runs
+
+// Daniel Valvano
+// January 29, 2015
+
+/* This example accompanies the book
+   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
+   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2015
+
+   Programs 4.4 through 4.12, section 4.2
+
+ Copyright 2015 by Jonathan W. Valvano, valvano@mail.utexas.edu
+    You may use, edit, run or distribute this file
+    as long as the above copyright notice remains
+ THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
+ OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ For more information about my classes, my research, and my books, see
+ http://users.ece.utexas.edu/~valvano/
+ */
+
+#include <stdint.h>
+#include "os.h"
+#include "BSP.h"
+#include "Clock.h"
+#include "Encoder.h"
+#include "Governor.h"
+#include "LCD.h"
+#include "Motor.h"
+#include "PLL.h"
+#include "SevenSeg.h"
+#include "Timer0A.h"
+#include "tm4c123gh6pm.h"
+
+#define TIMESLICE_MS  10     // thread switch time, converted to SysTick counts at the bus clock in main
+#define TASK_MS       10     // each thread's period
+#define LIGHT         2000   // bus cycles of work per period, 0.2 MHz
+#define HEAVY         200000 // thread 3's heavy phase, 20 MHz
+#define PHASE         500    // periods per phase of thread 3, about 5 s
+
+uint32_t Count1;   // number of times thread1 loops
+uint32_t Count2;   // number of times thread2 loops
+uint32_t Count3;   // number of times thread3 loops
+
+extern volatile uint32_t Slicecount; // time slices run, counted in os.c
+
+// speed controller gains, 1/256 of duty (1/65536) per 1/100 RPM
+static const struct Motor_Gains Gains = {
+  .kp = 256, .ki = 16, .kd = 64,
+  .kff = 1024,                   // full duty near 164 RPM at the output
+  .offset = 4096                 // 6% to overcome friction
+};
+
+// busy for work bus cycles from start, then asleep for the rest of
+// TASK_MS; the same work takes longer at a slower clock, and a period
+// it overruns isn't slept at all
+static void Run(uint32_t start, uint32_t work){
+  uint32_t ms;
+  while(BSP_Cycles() - start < work){}
+  ms = (BSP_Cycles() - start)/(PLL_BusClock()/1000);
+  if(ms < TASK_MS){
+    OS_Sleep(TASK_MS - ms);
+  }
+}
+
+void Task1(void)
+{
+  Count1 = 0;
+  for (;;)
+  {
+    uint32_t start = BSP_Cycles();
+    Count1++;
+    GPIO_PORTF_DATA_R = (GPIO_PORTF_DATA_R & ~0x0E) | (0x04 << 1); // Show green
+    Run(start, LIGHT);
+  }
+}
+
+void Task2(void){
+  Count2 = 0;
+  for(;;){
+    uint32_t start = BSP_Cycles();
+    Count2++;
+    GPIO_PORTF_DATA_R = (GPIO_PORTF_DATA_R & ~0x0E) | (0x02<<1);  // Show blue
+    Run(start, LIGHT);
+  }
+}
+
+void Task3(void){
+  Count3 = 0;
+  for(;;){
+    uint32_t start = BSP_Cycles();
+    Count3++;
+    GPIO_PORTF_DATA_R = (GPIO_PORTF_DATA_R & ~0x0E) | (0x03<<1);  // Show red + blue = purple/magenta
+    Run(start, ((Count3/PHASE)&1) ? HEAVY : LIGHT);
+  }
+}
+
+// periodic event: 1 on the left digit, the slice count on the right one
+void Display(void){
+  SevenSeg_Digit(0, 1);
+  SevenSeg_Digit(3, Slicecount%10);
+}
+
+#ifndef RTOS_BENCH    // bench.c supplies main for the benchmark builds
+int main(void){
+  OS_Init();           // initialize, disable interrupts, set the bus clock
+  Clock_Acquire(CLOCK_GPIO, CLOCK_PORTF); // LEDs
+  GPIO_PORTF_DIR_R |= 0x0E;             // make PF3-1 out
+  GPIO_PORTF_AFSEL_R &= ~0x0E;          // disable alt funct on PF3-1
+  GPIO_PORTF_DEN_R |= 0x0E;             // enable digital I/O on PF3-1
+  GPIO_PORTF_PCTL_R &= ~0x0000FFF0;     // configure PF3-1 as GPIO
+  GPIO_PORTF_AMSEL_R &= ~0x0E;          // disable analog functionality on PF3-1
+  OS_AddThreads(&Task1, &Task2, &Task3);
+  OS_AddThread(&Encoder_Thread);        // motor speed estimator
+  Motor_Start(&Gains);                  // speed control at 100 Hz, set speed 0
+  Governor_AddTask(&Motor_ComputeMax, MOTOR_CTRLFREQ);
+  OS_AddThread(&Governor_Thread);       // lowest bus clock that keeps up
+  OS_AddPeriodicEventThread(&Display, 10);
+  OS_Launch(PLL_BusClock()/1000*TIMESLICE_MS); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+#endif